@@ -10,7 +10,7 @@ UCSRC =
 
 UCXXSRC = ../src/supersaw.cpp
 
-UINCDIR =
+UINCDIR = $(PROJECTDIR)/../inc
 
 UDEFS =
 
@@ -0,0 +1,16 @@
+include $(PROJECTDIR)/project.mk
+
+LIB = $(HOSTBUILDDIR)/lib$(PROJECT).so
+SRC = $(addprefix $(PROJECTDIR)/, $(UCXXSRC))
+INC = $(addprefix -I, $(HOSTINCDIR) $(UINCDIR))
+
+all: $(LIB)
+
+$(LIB): $(SRC) $(wildcard $(UINCDIR)/*.h) $(wildcard $(dir $(SRC))*.h) $(wildcard $(HOSTINCDIR)/*) $(HOSTBUILDDIR)/liblogue.so
+	@echo Building $(notdir $@)
+	@$(CXX) $(HOSTCXXFLAGS) $(HOSTDEFS) $(UDEFS) $(INC) -shared -o $@ $(SRC) $(HOSTLDFLAGS) -llogue
+
+clean:
+	@rm -f $(LIB)
+
+.PHONY: all clean
@@ -0,0 +1,68 @@
+/*
+ * File: fixed_math.h
+ *
+ * Host stand-in for logue-sdk fixed point math.
+ *
+ * Mirrors ARM saturating semantics (QADD/QSUB/SSAT/VCVT)
+ * so the host renders match the target bit-exactly.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+#define Q7_MAX 0x7F
+#define Q15_MAX 0x7FFF
+#define Q31_MAX 0x7FFFFFFF
+
+#define M_1OVER48K_Q31 0x0000AEC3 //1/48000
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t ssat(const q31_t x, const uint32_t bits) {
+  const q31_t max = (1 << (bits - 1)) - 1;
+  const q31_t min = -max - 1;
+  return x > max ? max : x < min ? min : x;
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t qadd(const q31_t a, const q31_t b) {
+  const q63_t r = (q63_t)a + b;
+  return r > Q31_MAX ? Q31_MAX : r < -Q31_MAX - 1 ? -Q31_MAX - 1 : (q31_t)r;
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t qsub(const q31_t a, const q31_t b) {
+  const q63_t r = (q63_t)a - b;
+  return r > Q31_MAX ? Q31_MAX : r < -Q31_MAX - 1 ? -Q31_MAX - 1 : (q31_t)r;
+}
+
+  /**
+   * Float to Q31 conversion with VCVT-like saturation.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t f32_to_q31_sat(const float f) {
+  const float x = f * (float)0x7FFFFFFF;
+  return x >= 2147483648.f ? Q31_MAX : x <= -2147483648.f ? -Q31_MAX - 1 : (q31_t)x;
+}
+
+#define q31_to_f32_c 4.65661287307739e-010f
+#define q31_to_f32(q) ((float)(q) * q31_to_f32_c)
+#define f32_to_q31(f) f32_to_q31_sat((float)(f))
+
+#define q15_to_f32_c 3.05185094759972e-005f
+#define q15_to_f32(q) ((float)(q) * q15_to_f32_c)
+#define f32_to_q15(f) ((q15_t)ssat((q31_t)((float)(f) * (float)0x7FFF), 16))
+
+#define q31add(a,b) qadd((a),(b))
+#define q31sub(a,b) qsub((a),(b))
+#define q31mul(a,b) ((q31_t)(((q63_t)(q31_t)(a) * (q31_t)(b)) >> 31))
+#define q31abs(a) ((q31_t)((a) < 0 ? -(a) : (a)))
@@ -0,0 +1,66 @@
+/*
+ * File: fixtures.h
+ *
+ * Synthetic custom data for host oscillator runs.
+ *
+ * Each function fills a payload.bin image starting at
+ * OSC_HOST_PAYLOAD_OFFSET, ready for osc_host_inject().
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FIXTURE_FM64_DX7_BANK 0 //DX7 voices, voice N uses algorithm N+1
+#define FIXTURE_FM64_DX7_COUNT 32
+#define FIXTURE_FM64_DX11_BANK 1 //8 DX11 voices, voice N uses algorithm N+1
+#define FIXTURE_FM64_DX11_COUNT 8
+
+enum {
+  fixture_prog_mnlg = 0,
+  fixture_prog_molg,
+  fixture_prog_prlg_split,
+  fixture_prog_prlg_xfade,
+  fixture_prog_mnlgxd,
+  fixture_prog_num
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * FM64 voice banks
+   *
+   * @param data  Buffer to fill.
+   * @param size  Buffer size.
+   * @return      Custom data size.
+   */
+size_t fixture_fm64(uint8_t *data, size_t size);
+
+  /**
+   * Anthologue program list, one program per fixture_prog_* entry
+   *
+   * @param data  Buffer to fill.
+   * @param size  Buffer size.
+   * @return      Custom data size.
+   */
+size_t fixture_anthologue(uint8_t *data, size_t size);
+
+  /**
+   * Morpheus u-law wave bank, 64 waves of 256 samples
+   *
+   * @param data  Buffer to fill.
+   * @param size  Buffer size.
+   * @return      Custom data size.
+   */
+size_t fixture_morpheus(uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
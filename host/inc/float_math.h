@@ -0,0 +1,67 @@
+/*
+ * File: float_math.h
+ *
+ * Host stand-in for logue-sdk floating point math helpers.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#ifndef __fast_inline
+#define __fast_inline static inline __attribute__((always_inline, optimize("Ofast")))
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+__fast_inline float si_fabsf(float x) {
+  return fabsf(x);
+}
+
+__fast_inline float si_floorf(float x) {
+  return (float)((int32_t)x - (x < (int32_t)x ? 1 : 0));
+}
+
+__fast_inline float clipmaxf(const float x, const float m) {
+  return (x >= m) ? m : x;
+}
+
+__fast_inline float clipminf(const float m, const float x) {
+  return (x <= m) ? m : x;
+}
+
+__fast_inline float clipminmaxf(const float min, const float x, const float max) {
+  return (x >= max) ? max : (x <= min) ? min : x;
+}
+
+__fast_inline uint32_t clipmaxu32(const uint32_t x, const uint32_t m) {
+  return (x >= m) ? m : x;
+}
+
+__fast_inline float linintf(const float fr, const float x0, const float x1) {
+  return x0 + fr * (x1 - x0);
+}
+
+__fast_inline float dbampf(const float db) {
+  return powf(10.f, .05f * db);
+}
+
+__fast_inline float fastpow2f(const float p) {
+  const float offset = (p < 0) ? 1.0f : 0.0f;
+  const float clipp = (p < -126) ? -126.0f : p;
+  const int32_t w = clipp;
+  const float z = clipp - w + offset;
+  const union { uint32_t i; float f; } v = { (uint32_t)((1 << 23) * (clipp + 121.2740575f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z)) };
+  return v.f;
+}
+
+__fast_inline float ampdbf(const float amp) {
+  return (amp < 0.f) ? -999.f : 20.f * log10f(amp);
+}
@@ -0,0 +1,43 @@
+/*
+ * File: fx_api.h
+ *
+ * Host stand-in for logue-sdk effects runtime API.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "float_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint16_t _fx_get_bpm(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+  /**
+   * Get current tempo
+   *
+   * @return     Tempo in BPM * 10.
+   */
+__fast_inline uint16_t fx_get_bpm(void) {
+  return _fx_get_bpm();
+}
+
+  /**
+   * Get current tempo
+   *
+   * @return     Tempo in BPM.
+   */
+__fast_inline float fx_get_bpmf(void) {
+  return (float)_fx_get_bpm() * .1f;
+}
@@ -0,0 +1,220 @@
+/*
+ * File: osc_api.h
+ *
+ * Host stand-in for logue-sdk oscillator runtime API.
+ *
+ * Provides the subset of the runtime used by the oscillators:
+ * note to frequency, sine and band-limited sawtooth LUTs,
+ * wave banks and white noise. LUT contents are generated by
+ * the host runtime (host/src/logue.cpp) on load.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fixed_math.h"
+#include "float_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define k_samplerate 48000
+#define k_samplerate_recipf 2.08333333333333e-005f
+
+  /**
+   * Oscillator parameter passed to the cycle hook.
+   */
+typedef struct user_osc_param {
+  int32_t shape_lfo;
+  uint16_t pitch;
+  uint16_t cutoff;
+  uint16_t resonance;
+  uint16_t reserved0[3];
+} user_osc_param_t;
+
+typedef enum {
+  k_user_osc_param_id1 = 0,
+  k_user_osc_param_id2,
+  k_user_osc_param_id3,
+  k_user_osc_param_id4,
+  k_user_osc_param_id5,
+  k_user_osc_param_id6,
+  k_user_osc_param_shape,
+  k_user_osc_param_shiftshape,
+  k_num_user_osc_param_id
+} user_osc_param_id_t;
+
+enum {
+  k_user_target_prologue = (1U << 8),
+  k_user_target_miniloguexd = (2U << 8),
+  k_user_target_nutektdigital = (3U << 8),
+  k_user_target_platform_mask = (0x7FU << 8),
+};
+
+#define param_val_to_f32(val) ((uint16_t)(val) * 9.77517106549365e-004f)
+
+#define k_midi_to_hz_size 152
+#define k_note_mod_fscale .00392156862745098f
+#define k_note_max_hz 23679.643054f
+
+extern const float midi_to_hz_lut_f[k_midi_to_hz_size];
+
+#define k_wt_sine_size_exp 7
+#define k_wt_sine_size (1U << k_wt_sine_size_exp)
+#define k_wt_sine_mask (k_wt_sine_size - 1)
+#define k_wt_sine_lut_size (k_wt_sine_size + 1)
+
+extern const float wt_sine_lut_f[k_wt_sine_lut_size];
+
+#define k_wt_saw_size_exp 6
+#define k_wt_saw_size (1U << k_wt_saw_size_exp)
+#define k_wt_saw_mask (k_wt_saw_size - 1)
+#define k_wt_saw_lut_size (k_wt_saw_size + 1)
+#define k_wt_saw_notes_cnt 7
+#define k_wt_saw_lut_tsize (k_wt_saw_notes_cnt * k_wt_saw_lut_size)
+
+extern const float wt_saw_lut_f[k_wt_saw_lut_tsize];
+
+#define k_waves_size_exp 7
+#define k_waves_size (1U << k_waves_size_exp)
+#define k_waves_mask (k_waves_size - 1)
+#define k_waves_lut_size (k_waves_size + 1)
+
+#define k_waves_a_cnt 16
+#define k_waves_b_cnt 16
+#define k_waves_c_cnt 14
+#define k_waves_d_cnt 13
+#define k_waves_e_cnt 15
+#define k_waves_f_cnt 16
+
+extern const float * const wavesA[k_waves_a_cnt];
+extern const float * const wavesB[k_waves_b_cnt];
+extern const float * const wavesC[k_waves_c_cnt];
+extern const float * const wavesD[k_waves_d_cnt];
+extern const float * const wavesE[k_waves_e_cnt];
+extern const float * const wavesF[k_waves_f_cnt];
+
+float _osc_white(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+  /**
+   * Get Hertz value for note
+   *
+   * @param note Note in [0-151] range.
+   * @return     Corresponding Hertz value.
+   */
+__fast_inline float osc_notehzf(uint8_t note) {
+  return midi_to_hz_lut_f[clipmaxu32(note, k_midi_to_hz_size - 1)];
+}
+
+  /**
+   * Get floating point phase increment for given note and fine modulation
+   *
+   * @param note Note in [0-151] range, mod in [0-255] range.
+   * @return     Corresponding 0-1 phase increment in floating point.
+   */
+__fast_inline float osc_w0f_for_note(uint8_t note, uint8_t mod) {
+  const float f0 = osc_notehzf(note);
+  const float f1 = osc_notehzf(note + 1);
+  const float f = clipmaxf(linintf(mod * k_note_mod_fscale, f0, f1), k_note_max_hz);
+  return f * k_samplerate_recipf;
+}
+
+  /**
+   * Sine wave lookup.
+   *
+   * @param   x  Phase in [0, 1.0).
+   * @return     Value in [-1.0, 1.0].
+   */
+__fast_inline float osc_sinf(float x) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_sine_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  const uint32_t x0 = x0p & k_wt_sine_mask;
+  const uint32_t x1 = (x0 + 1) & k_wt_sine_mask;
+  const float y0 = linintf(x0f - x0p, wt_sine_lut_f[x0], wt_sine_lut_f[x1]);
+  return (x0p < k_wt_sine_size) ? y0 : -y0;
+}
+
+  /**
+   * Band-limited sawtooth wave lookup.
+   *
+   * @param   x    Phase in [0, 1.0).
+   * @param   idx  Wave index in [0,6].
+   * @return       Value in [-1.0, 1.0].
+   */
+__fast_inline float osc_bl_sawf(float x, uint8_t idx) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_saw_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  uint32_t x0 = x0p, x1 = x0p + 1;
+  float sign = 1.f;
+  if (x0p >= k_wt_saw_size) {
+    x0 = k_wt_saw_size - (x0p & k_wt_saw_mask);
+    x1 = x0 - 1;
+    sign = -1.f;
+  }
+  const float *wt = &wt_saw_lut_f[clipmaxu32(idx, k_wt_saw_notes_cnt - 1) * k_wt_saw_lut_size];
+  return sign * linintf(x0f - x0p, wt[x0], wt[x1]);
+}
+
+  /**
+   * Band-limited sawtooth wave lookup, interpolated version.
+   *
+   * @param   x    Phase in [0, 1.0).
+   * @param   idx  Fractional wave index in [0,6].
+   * @return       Value in [-1.0, 1.0].
+   */
+__fast_inline float osc_bl2_sawf(float x, float idx) {
+  const float p = x - (uint32_t)x;
+  const float x0f = 2.f * p * k_wt_saw_size;
+  const uint32_t x0p = (uint32_t)x0f;
+  uint32_t x0 = x0p, x1 = x0p + 1;
+  float sign = 1.f;
+  if (x0p >= k_wt_saw_size) {
+    x0 = k_wt_saw_size - (x0p & k_wt_saw_mask);
+    x1 = x0 - 1;
+    sign = -1.f;
+  }
+  const float fr = x0f - x0p;
+  const uint32_t idx0 = clipmaxu32((uint32_t)idx, k_wt_saw_notes_cnt - 2);
+  const float *wt = &wt_saw_lut_f[idx0 * k_wt_saw_lut_size];
+  const float y0 = sign * linintf(fr, wt[x0], wt[x1]);
+  wt += k_wt_saw_lut_size;
+  const float y1 = sign * linintf(fr, wt[x0], wt[x1]);
+  return linintf(idx - idx0, y0, y1);
+}
+
+  /**
+   * Wave bank lookup.
+   *
+   * @param   w  Wave table.
+   * @param   x  Phase in [0, 1.0).
+   * @return     Value in [-1.0, 1.0].
+   */
+__fast_inline float osc_wave_scanf(const float *w, float x) {
+  const float p = x - (uint32_t)x;
+  const float x0f = p * k_waves_size;
+  const uint32_t x0 = ((uint32_t)x0f) & k_waves_mask;
+  const uint32_t x1 = (x0 + 1) & k_waves_mask;
+  return linintf(x0f - (uint32_t)x0f, w[x0], w[x1]);
+}
+
+  /**
+   * White noise source.
+   *
+   * @return     Value in [-1.0, 1.0].
+   */
+__fast_inline float osc_white(void) {
+  return _osc_white();
+}
@@ -0,0 +1,100 @@
+/*
+ * File: osc_host.h
+ *
+ * Host runtime control and oscillator library loader.
+ *
+ * Each oscillator is built by host.mk as a native shared library
+ * exporting the OSC_* hooks only. The loader resolves the hooks
+ * and exposes the .hooks custom data section, so voice banks,
+ * programs and wave banks can be injected the same way the
+ * *.sh injectors do for payload.bin.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "userosc.h"
+
+#define OSC_HOST_FRAMES_MAX 64 //maximum frames per cycle, same as the target runtime
+#define OSC_HOST_PAYLOAD_OFFSET 64 //custom data offset in payload.bin used by the injectors
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct osc_host_t {
+  void *handle;
+  void (*init)(uint32_t platform, uint32_t api);
+  void (*cycle)(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames);
+  void (*noteon)(const user_osc_param_t * const params);
+  void (*noteoff)(const user_osc_param_t * const params);
+  void (*param)(uint16_t index, uint16_t value);
+  uint8_t *data; //.hooks custom data section
+  size_t data_size;
+  const struct perf_ring_t *perf; //block stats of a PERF_ENABLE build, see inc/perf.h
+};
+
+  /**
+   * Set tempo returned by fx_get_bpm()
+   *
+   * @param bpm  Tempo in BPM * 10.
+   */
+void osc_host_set_bpm(uint16_t bpm);
+
+  /**
+   * Reset white noise generator to a known state
+   *
+   * @param seed  Non-zero seed value.
+   */
+void osc_host_seed(uint32_t seed);
+
+  /**
+   * Set host time scale of the cycle counter
+   *
+   * @param ns  Host nanoseconds per target cycle, zero stops the counter.
+   */
+void osc_host_set_cycle_ns(double ns);
+
+  /**
+   * Target cycle counter stand-in, used by inc/governor.h
+   *
+   * @return  Host time in target cycles, wrapping.
+   */
+uint32_t osc_host_cycles(void);
+
+  /**
+   * Load oscillator library and resolve hooks
+   *
+   * @param osc   Oscillator handle.
+   * @param path  Library path.
+   * @return      Zero on success.
+   */
+int osc_host_open(osc_host_t *osc, const char *path);
+
+  /**
+   * Unload oscillator library.
+   *
+   * @param osc   Oscillator handle.
+   */
+void osc_host_close(osc_host_t *osc);
+
+  /**
+   * Write custom data to oscillator .hooks section
+   *
+   * @param osc     Oscillator handle.
+   * @param offset  Offset in payload.bin, as used by the injectors.
+   * @param src     Data to write.
+   * @param size    Data size.
+   * @return        Number of bytes written.
+   */
+size_t osc_host_inject(osc_host_t *osc, size_t offset, const void *src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+/*
+ * File: simplelfo.hpp
+ *
+ * Host stand-in for logue-sdk simple LFO.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include "osc_api.h"
+
+namespace dsp {
+
+  /**
+   * Q31 phase accumulator LFO, phase in [-1.0, 1.0).
+   */
+  struct SimpleLFO {
+
+    SimpleLFO(void) :
+      phi0(0x80000000),
+      w0(0)
+    { }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    void cycle(void) {
+      phi0 = (q31_t)((uint32_t)phi0 + (uint32_t)w0);
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    void reset(void) {
+      phi0 = 0x80000000;
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    void setW0(const float w) {
+      w0 = f32_to_q31(2.f * w);
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    void setF0(const float f0, const float fsrecip) {
+      w0 = f32_to_q31(2.f * f0 * fsrecip);
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    float sine_bi(void) {
+      const float phi = q31_to_f32(phi0) * .5f + .5f;
+      return osc_sinf(phi);
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    float sine_uni(void) {
+      return .5f + .5f * sine_bi();
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    float triangle_bi(void) {
+      return 1.f - 2.f * si_fabsf(q31_to_f32(phi0));
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    float triangle_uni(void) {
+      return si_fabsf(q31_to_f32(phi0));
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    float saw_bi(void) {
+      return q31_to_f32(phi0);
+    }
+
+    inline __attribute__((optimize("Ofast"), always_inline))
+    float saw_uni(void) {
+      return .5f + .5f * q31_to_f32(phi0);
+    }
+
+    q31_t phi0;
+    q31_t w0;
+  };
+}
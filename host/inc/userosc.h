@@ -0,0 +1,45 @@
+/*
+ * File: userosc.h
+ *
+ * Host stand-in for logue-sdk user oscillator declarations.
+ *
+ * Hooks are exported with default visibility so the host loader
+ * can resolve them from an oscillator library built with
+ * -fvisibility=hidden.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "osc_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSC_HOOK __attribute__((used, visibility("default")))
+
+#define OSC_INIT    OSC_HOOK _hook_init
+#define OSC_CYCLE   OSC_HOOK _hook_cycle
+#define OSC_NOTEON  OSC_HOOK _hook_on
+#define OSC_NOTEOFF OSC_HOOK _hook_off
+#define OSC_MUTE    OSC_HOOK _hook_mute
+#define OSC_VALUE   OSC_HOOK _hook_value
+#define OSC_PARAM   OSC_HOOK _hook_param
+
+void _hook_init(uint32_t platform, uint32_t api);
+void _hook_cycle(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames);
+void _hook_on(const user_osc_param_t * const params);
+void _hook_off(const user_osc_param_t * const params);
+void _hook_mute(const user_osc_param_t * const params);
+void _hook_value(uint16_t value);
+void _hook_param(uint16_t index, uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif
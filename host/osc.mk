@@ -0,0 +1,16 @@
+# #############################################################################
+# Host platform stand-in
+# #############################################################################
+#
+# Included by */project.mk through PLATFORMDIR when building with host.mk,
+# in place of the logue-sdk platform osc.mk.
+
+HOSTDIR := $(abspath $(PLATFORMDIR))
+HOSTBUILDDIR = $(HOSTDIR)/build
+HOSTINCDIR = $(HOSTDIR)/inc
+
+CXX ?= g++
+HOSTCXXFLAGS = -std=gnu++11 -O2 -g -fPIC -fvisibility=hidden -Wall -Wno-unused-function -Wno-unused-variable
+#make host PERF=1 to build the oscillators with inc/perf.h instrumentation
+HOSTDEFS = $(if $(PERF),-DPERF_ENABLE)
+HOSTLDFLAGS = -L$(HOSTBUILDDIR) -Wl,-rpath,'$$ORIGIN'
@@ -0,0 +1,416 @@
+/*
+ * File: bench.cpp
+ *
+ * OSC_CYCLE benchmark suite.
+ *
+ * Runs every oscillator over representative parameter sweeps
+ * and reports host ns/sample together with an estimated
+ * Cortex-M4 cycles/sample and the fraction of the per-sample
+ * cycle budget of each platform.
+ *
+ * Each case is initialized and run once per platform, so the
+ * oscillators apply their own voice and VCO budgets of it.
+ * ns/sample and M4 cycles/sample are of the nutekt-digital run.
+ *
+ * M4 cycles are estimated by calibrating against a reference
+ * Q31 LUT oscillator kernel with a known M4 cycle count, so the
+ * numbers are comparable between host machines, but still only
+ * an estimate. Use them to track relative changes.
+ *
+ * With -g the oscillator CPU governor is fed with the estimated
+ * M4 cycles, so the figures show the governed cost on each platform.
+ *
+ * With -p block cost histograms are printed for oscillators
+ * built with PERF=1, see inc/perf.h.
+ *
+ * Usage: osc_bench [-j] [-g] [-p] [-b blocks] [-r repeats] [-l libdir] [filter]
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osc_host.h"
+#include "fixtures.h"
+#include "perf.h"
+
+#define FRAMES 64 //block size used by the target runtime
+#define BLOCKS 750 //1 second
+#define REPEATS 5
+#define DATA_SIZE_MAX 0x10000
+
+//reference kernel: phase add, index/fraction split, 2 LUT loads, interpolation, accumulate, loop
+#define REF_M4_CYCLES 15
+#define REF_LUT_SIZE_EXP 7
+#define REF_ITERATIONS 1000000
+
+#define PARAM_MAX 1023
+#define HISTOGRAM_BINS 10
+#define HISTOGRAM_WIDTH 40
+
+static const struct {
+  const char *name;
+  uint32_t target; //init platform argument
+  uint32_t clock; //core clock, Hz
+} s_platforms[] = {
+  {"prologue", k_user_target_prologue, 84000000},
+  {"minilogue-xd", k_user_target_miniloguexd, 84000000},
+  {"nutekt-digital", k_user_target_nutektdigital, 180000000},
+};
+
+#define PLATFORM_COUNT (sizeof(s_platforms) / sizeof(s_platforms[0]))
+
+struct bench_case_t {
+  const char *osc;
+  char name[32];
+  void (*setup)(osc_host_t *osc, const bench_case_t *c, user_osc_param_t *params);
+  size_t (*fixture)(uint8_t *data, size_t size);
+  uint32_t arg[3];
+};
+
+static uint8_t s_data[DATA_SIZE_MAX];
+static double s_governor_cycle_ns; //zero keeps the governor at full quality
+static perf_ring_t s_perf; //block stats copy of the last case run
+static char s_perf_name[PERF_SECTION_COUNT][32]; //section names outlive the library
+static bool s_has_perf;
+
+static void param_defaults(osc_host_t *osc) {
+  for (uint32_t index = k_num_user_osc_param_id; index--;)
+    osc->param(index, 0);
+}
+
+static void noteon(osc_host_t *osc, user_osc_param_t *params, uint8_t note) {
+  params->pitch = note << 8;
+  osc->noteon(params);
+}
+
+//arg: unison pairs, polyphony
+static void setup_saw(osc_host_t *osc, const bench_case_t *c, user_osc_param_t *params) {
+  param_defaults(osc);
+  osc->param(k_user_osc_param_id1, c->arg[0] - 1);
+  osc->param(k_user_osc_param_id2, 20);
+  osc->param(k_user_osc_param_id6, c->arg[1] - 1);
+  osc->param(k_user_osc_param_shape, PARAM_MAX);
+  osc->param(k_user_osc_param_shiftshape, PARAM_MAX / 2);
+  for (uint32_t i = 0; i < c->arg[1]; i++)
+    noteon(osc, params, 48 + i * 2);
+}
+
+//arg: bank, voice, polyphony
+static void setup_fm64(osc_host_t *osc, const bench_case_t *c, user_osc_param_t *params) {
+  param_defaults(osc);
+  osc->param(k_user_osc_param_id2, c->arg[0]);
+  osc->param(k_user_osc_param_id1, c->arg[1]);
+  osc->param(k_user_osc_param_id6, c->arg[2] - 1);
+  for (uint32_t i = 0; i < c->arg[2]; i++)
+    noteon(osc, params, 60 + i * 4);
+}
+
+//arg: program, play mode, quality
+static void setup_anthologue(osc_host_t *osc, const bench_case_t *c, user_osc_param_t *params) {
+  param_defaults(osc);
+  osc->param(k_user_osc_param_id1, c->arg[0]);
+  osc->param(k_user_osc_param_id3, c->arg[1]);
+  osc->param(k_user_osc_param_id6, c->arg[2]);
+  noteon(osc, params, 60);
+}
+
+//arg: mode, interpolate
+static void setup_morpheus(osc_host_t *osc, const bench_case_t *c, user_osc_param_t *params) {
+  param_defaults(osc);
+  osc->param(k_user_osc_param_id1, c->arg[0]);
+  osc->param(k_user_osc_param_id2, 1);
+  osc->param(k_user_osc_param_id3, 3);
+  osc->param(k_user_osc_param_id5, c->arg[1]);
+  osc->param(k_user_osc_param_shape, PARAM_MAX / 2);
+  osc->param(k_user_osc_param_shiftshape, PARAM_MAX / 3);
+  noteon(osc, params, 60);
+}
+
+static uint32_t bench_cases(bench_case_t *cases) {
+  static const uint8_t saw_grid[] = {1, 6, 12};
+  static const char *prog_names[fixture_prog_num] = {"mnlg", "molg", "prlg_split", "prlg_xfade", "mnlgxd"};
+  static const char *mode_names[] = {"note", "seq", "note,blep"};
+  static const struct {
+    uint8_t bank;
+    uint8_t alg;
+    uint8_t poly; //voices within the NTS-1 budget
+  } fm64_heavy[] = {
+    {FIXTURE_FM64_DX7_BANK, 4, 3},
+    {FIXTURE_FM64_DX7_BANK, 6, 3},
+    {FIXTURE_FM64_DX7_BANK, 11, 3},
+    {FIXTURE_FM64_DX7_BANK, 32, 3},
+    {FIXTURE_FM64_DX11_BANK, 8, 4},
+  };
+  bench_case_t *c = cases;
+
+  for (uint32_t k = 0; k < 2; k++) {
+    for (uint32_t i = 0; i < sizeof(saw_grid); i++) {
+      for (uint32_t j = 0; j < sizeof(saw_grid); j++, c++) {
+        c->osc = k ? "FastSaw" : "Supersaw";
+        snprintf(c->name, sizeof(c->name), "unison=%u,poly=%u", saw_grid[i], saw_grid[j]);
+        c->setup = setup_saw;
+        c->arg[0] = saw_grid[i];
+        c->arg[1] = saw_grid[j];
+      }
+    }
+  }
+  for (uint32_t i = 0; i < FIXTURE_FM64_DX7_COUNT; i++, c++) {
+    c->osc = "FM64";
+    snprintf(c->name, sizeof(c->name), "dx7,alg=%u", i + 1);
+    c->setup = setup_fm64;
+    c->fixture = fixture_fm64;
+    c->arg[0] = FIXTURE_FM64_DX7_BANK;
+    c->arg[1] = i;
+    c->arg[2] = 1;
+  }
+  for (uint32_t i = 0; i < FIXTURE_FM64_DX11_COUNT; i++, c++) {
+    c->osc = "FM64";
+    snprintf(c->name, sizeof(c->name), "dx11,alg=%u", i + 1);
+    c->setup = setup_fm64;
+    c->fixture = fixture_fm64;
+    c->arg[0] = FIXTURE_FM64_DX11_BANK;
+    c->arg[1] = i;
+    c->arg[2] = 1;
+  }
+//heaviest algorithms of each bank with the voice pool filled up to the NTS-1 budget:
+//alg 4 and 6 run the feedback loop per sample, alg 11 and 32 are the heaviest block kernels
+  for (uint32_t i = 0; i < sizeof(fm64_heavy) / sizeof(fm64_heavy[0]); i++) {
+    for (uint32_t j = 2; j <= fm64_heavy[i].poly; j++, c++) {
+      c->osc = "FM64";
+      snprintf(c->name, sizeof(c->name), "%s,alg=%u,poly=%u", fm64_heavy[i].bank ? "dx11" : "dx7", fm64_heavy[i].alg, j);
+      c->setup = setup_fm64;
+      c->fixture = fixture_fm64;
+      c->arg[0] = fm64_heavy[i].bank;
+      c->arg[1] = fm64_heavy[i].alg - 1;
+      c->arg[2] = j;
+    }
+  }
+  for (uint32_t i = 0; i < fixture_prog_num; i++) {
+    for (uint32_t j = 0; j < 3; j++, c++) {
+      c->osc = "Anthologue";
+      snprintf(c->name, sizeof(c->name), "%s,%s", prog_names[i], mode_names[j]);
+      c->setup = setup_anthologue;
+      c->fixture = fixture_anthologue;
+      c->arg[0] = i;
+      c->arg[1] = j & 1;
+      c->arg[2] = j >> 1;
+    }
+  }
+  for (uint32_t i = 0; i < 2; i++) {
+    for (uint32_t j = 0; j < 2; j++, c++) {
+      c->osc = "Morpheus";
+      snprintf(c->name, sizeof(c->name), "mode=%s,interpolate=%s", i ? "grid" : "linear", j ? "on" : "off");
+      c->setup = setup_morpheus;
+      c->fixture = fixture_morpheus;
+      c->arg[0] = i;
+      c->arg[1] = j;
+    }
+  }
+  return c - cases;
+}
+
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static double median(double *v, uint32_t n) {
+  qsort(v, n, sizeof(*v), compare);
+  return v[n >> 1];
+}
+
+//host ns per M4 cycle, measured on the reference kernel
+static double calibrate(uint32_t repeats) {
+  static q31_t lut[(1 << REF_LUT_SIZE_EXP) + 1];
+  double t[REPEATS * 4];
+  for (uint32_t i = 0; i <= (1 << REF_LUT_SIZE_EXP); i++)
+    lut[i] = f32_to_q31(wt_sine_lut_f[i * k_wt_sine_size >> REF_LUT_SIZE_EXP]);
+  for (uint32_t r = 0; r < repeats; r++) {
+    uint32_t phase = 0;
+    q31_t acc = 0;
+    const double start = now_ns();
+    for (uint32_t i = REF_ITERATIONS; i--;) {
+      phase += 0x01234567;
+      const uint32_t x0 = phase >> (32 - REF_LUT_SIZE_EXP);
+      const q31_t fr = (phase << REF_LUT_SIZE_EXP) >> 1;
+      acc = q31add(acc, lut[x0] + q31mul(fr, lut[x0 + 1] - lut[x0]));
+      __asm__ volatile("" : "+r"(acc), "+r"(phase));
+    }
+    t[r] = (now_ns() - start) / ((double)REF_ITERATIONS * REF_M4_CYCLES);
+  }
+  return median(t, repeats);
+}
+
+static double run_case(const char *libdir, const bench_case_t *c, uint32_t platform, uint32_t blocks, uint32_t repeats) {
+  osc_host_t osc;
+  user_osc_param_t params = {};
+  int32_t buf[FRAMES];
+  double t[REPEATS * 4];
+  char path[PATH_MAX];
+
+  snprintf(path, sizeof(path), "%s/lib%s.so", libdir, c->osc);
+  if (osc_host_open(&osc, path))
+    return -1.;
+  osc_host_seed(0);
+  osc_host_set_cycle_ns(s_governor_cycle_ns);
+//custom data is in place before init on the target
+  if (c->fixture)
+    osc_host_inject(&osc, OSC_HOST_PAYLOAD_OFFSET, s_data, c->fixture(s_data, sizeof(s_data)));
+  osc.init(platform, 0);
+  c->setup(&osc, c, &params);
+  for (uint32_t i = blocks >> 3; i--; osc.cycle(&params, buf, FRAMES)); //warm up
+  for (uint32_t r = 0; r < repeats; r++) {
+    const double start = now_ns();
+    for (uint32_t i = blocks; i--; osc.cycle(&params, buf, FRAMES));
+    t[r] = (now_ns() - start) / ((double)blocks * FRAMES);
+  }
+  if ((s_has_perf = osc.perf != NULL)) {
+    s_perf = *osc.perf;
+    for (uint32_t j = s_perf.section_count; j--;) {
+      snprintf(s_perf_name[j], sizeof(s_perf_name[j]), "%s", s_perf.name[j]);
+      s_perf.name[j] = s_perf_name[j];
+    }
+  }
+  osc_host_close(&osc);
+  return median(t, repeats);
+}
+
+//host counts nanoseconds, reported as M4 cycles per sample
+static void print_perf(const perf_ring_t *perf, double ns_per_cycle) {
+  double cost[PERF_RING_SIZE], section[PERF_SECTION_COUNT] = {}, total = 0.;
+  uint32_t bins[HISTOGRAM_BINS] = {}, peak = 0;
+  const uint32_t n = perf->count < PERF_RING_SIZE ? perf->count : PERF_RING_SIZE;
+  if (n == 0)
+    return;
+  for (uint32_t i = 0; i < n; i++) {
+    const perf_block_t *b = &perf->block[i];
+    cost[i] = b->total / ns_per_cycle / b->frames;
+    total += b->total;
+    for (uint32_t j = perf->section_count; j--;)
+      section[j] += b->section[j];
+  }
+  printf("  blocks %u", n);
+  for (uint32_t j = 0; j < perf->section_count; j++)
+    printf(", %s %.1f%%", perf->name[j], 100. * section[j] / total);
+  printf("\n");
+  qsort(cost, n, sizeof(*cost), compare);
+  const double lo = cost[0], hi = cost[n - 1], bin = (hi - lo) / HISTOGRAM_BINS;
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t k = bin > 0. ? (uint32_t)((cost[i] - lo) / bin) : 0;
+    if (k >= HISTOGRAM_BINS)
+      k = HISTOGRAM_BINS - 1;
+    if (++bins[k] > peak)
+      peak = bins[k];
+  }
+  for (uint32_t k = 0; k < HISTOGRAM_BINS; k++) {
+    printf("  %8.1f %5u ", lo + bin * k, bins[k]);
+    for (uint32_t i = bins[k] * HISTOGRAM_WIDTH / peak; i--; putchar('#'));
+    printf("\n");
+    if (bin <= 0.)
+      break;
+  }
+}
+
+int main(int argc, char **argv) {
+  static bench_case_t cases[128];
+  const char *filter = NULL;
+  const char *libdir = dirname(strdup(argv[0]));
+  uint32_t blocks = BLOCKS, repeats = REPEATS;
+  bool json = false, governor = false, perf = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "jgpb:r:l:")) != -1) {
+    switch (opt) {
+      case 'j':
+        json = true;
+        break;
+      case 'g':
+        governor = true;
+        break;
+      case 'p':
+        perf = true;
+        break;
+      case 'b':
+        blocks = atoi(optarg);
+        break;
+      case 'r':
+        repeats = atoi(optarg);
+        if (repeats < 1 || repeats > REPEATS * 4)
+          repeats = REPEATS;
+        break;
+      case 'l':
+        libdir = optarg;
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-j] [-g] [-p] [-b blocks] [-r repeats] [-l libdir] [filter]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind < argc)
+    filter = argv[optind];
+
+  const double ns_per_cycle = calibrate(repeats);
+  if (governor)
+    s_governor_cycle_ns = ns_per_cycle;
+  const uint32_t count = bench_cases(cases);
+
+  if (json) {
+    printf("{\"frames\":%u,\"ns_per_m4_cycle\":%.6f,\"platforms\":{", FRAMES, ns_per_cycle);
+    for (uint32_t p = 0; p < PLATFORM_COUNT; p++)
+      printf("%s\"%s\":%u", p ? "," : "", s_platforms[p].name, s_platforms[p].clock / k_samplerate);
+    printf("},\"results\":[");
+  } else {
+    printf("%-10s %-28s %10s %10s", "osc", "case", "ns/sample", "M4 cyc/s");
+    for (uint32_t p = 0; p < PLATFORM_COUNT; p++)
+      printf(" %14s", s_platforms[p].name);
+    printf("\n");
+  }
+  for (uint32_t i = 0, n = 0; i < count; i++) {
+    const bench_case_t *c = &cases[i];
+    char id[64];
+    snprintf(id, sizeof(id), "%s/%s", c->osc, c->name);
+    if (filter && !strstr(id, filter))
+      continue;
+    double platform_cycles[PLATFORM_COUNT];
+    double ns = 0.;
+//nutekt-digital goes last, its run is reported as ns and M4 cycles and kept for -p
+    for (uint32_t p = 0; p < PLATFORM_COUNT; p++) {
+      if ((ns = run_case(libdir, c, s_platforms[p].target, blocks, repeats)) < 0.)
+        return 1;
+      platform_cycles[p] = ns / ns_per_cycle;
+    }
+    const double cycles = ns / ns_per_cycle;
+    if (json) {
+      printf("%s{\"osc\":\"%s\",\"case\":\"%s\",\"ns_per_sample\":%.3f,\"m4_cycles_per_sample\":%.1f,\"budget\":{", n++ ? "," : "", c->osc, c->name, ns, cycles);
+      for (uint32_t p = 0; p < PLATFORM_COUNT; p++)
+        printf("%s\"%s\":%.4f", p ? "," : "", s_platforms[p].name, platform_cycles[p] * k_samplerate / s_platforms[p].clock);
+      printf("}}");
+    } else {
+      printf("%-10s %-28s %10.2f %10.1f", c->osc, c->name, ns, cycles);
+      for (uint32_t p = 0; p < PLATFORM_COUNT; p++)
+        printf(" %13.1f%%", 100. * platform_cycles[p] * k_samplerate / s_platforms[p].clock);
+      printf("\n");
+      if (perf && s_has_perf)
+        print_perf(&s_perf, ns_per_cycle);
+    }
+    fflush(stdout);
+  }
+  if (json)
+    printf("]}\n");
+  return 0;
+}
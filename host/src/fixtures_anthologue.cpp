@@ -0,0 +1,197 @@
+/*
+ * File: fixtures_anthologue.cpp
+ *
+ * Synthetic logue-series programs.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "fixtures.h"
+#include "osc_host.h"
+#include "../../src/anthologue.h"
+
+#define MARK_PROG 0x474F5250
+#define MARK_SEQD 0x44514553
+#define MARK_PRED 0x44455250
+
+#define PITCH_CENTER 512
+#define LEVEL_MAX 1023
+#define STEP_NOTE(i) (48 + ((i) * 5) % 24)
+
+static void prlg_timbre(prlg_timbre_t *t, uint32_t n) {
+  t->vco1_wave = wave_saw;
+  t->vco1_octave = 1;
+  t->vco1_pitch = PITCH_CENTER;
+  t->vco1_shape = 256 + n * 128;
+  t->vco2_wave = n ? wave_tri : wave_sqr;
+  t->vco2_octave = 2;
+  t->vco2_pitch_hi = (PITCH_CENTER + 40) >> 8;
+  t->vco2_pitch_lo = (PITCH_CENTER + 40) & 0xFF;
+  t->vco2_shape_hi = 512 >> 8;
+  t->ring_sync = 1;
+  t->cross_mod_depth = 128;
+  t->multi_type = multi_noise;
+  t->multi_octave = 1;
+  t->noise_shape = 512;
+  t->vco1_level = LEVEL_MAX;
+  t->vco2_level = 768;
+  t->multi_level = 128;
+  t->bend_range_pos = 2;
+  t->bend_range_neg = 2;
+}
+
+static size_t prlg_prog(uint8_t *data, uint8_t timbre_type) {
+  prlg_prog_t *p = (prlg_prog_t *)data;
+  memset(p, 0, sizeof(*p));
+  p->PROG = MARK_PROG;
+  snprintf(p->name, sizeof(p->name), timbre_type == timbre_split ? "PRLG SPLIT" : "PRLG XFADE");
+  p->keyboard_octave = 2;
+  p->sub_on_pgm_fetch = 1;
+  p->timbre_type = timbre_type;
+  p->main_sub_balance = 64;
+  p->split_point = 60;
+  p->bpm = 1200;
+  p->program_level = 100;
+  prlg_timbre(&p->timbre[0], 0);
+  prlg_timbre(&p->timbre[1], 1);
+  p->PRED = MARK_PRED;
+  return sizeof(*p);
+}
+
+static size_t mnlg_prog(uint8_t *data) {
+  mnlg_prog_t *p = (mnlg_prog_t *)data;
+  memset(p, 0, sizeof(*p));
+  p->PROG = MARK_PROG;
+  snprintf(p->name, sizeof(p->name), "MNLG SEQ");
+  p->vco1_pitch_hi = PITCH_CENTER >> 2;
+  p->vco2_pitch_hi = (PITCH_CENTER + 20) >> 2;
+  p->vco1_shape_hi = 64;
+  p->vco2_shape_hi = 128;
+  p->cross_mod_depth_hi = 16;
+  p->vco1_level_hi = LEVEL_MAX >> 2;
+  p->vco2_level_hi = 192;
+  p->noise_level_hi = 16;
+  p->vco1_octave = 1;
+  p->vco1_wave = wave_saw;
+  p->vco2_octave = 2;
+  p->vco2_wave = wave_sqr;
+  p->sync = 1;
+  p->ring = 1;
+  p->bend_range_pos = 2;
+  p->bend_range_neg = 2;
+  p->program_level = 102;
+  p->keyboard_octave = 2;
+  p->SEQD = MARK_SEQD;
+  p->bpm = 1200;
+  p->step_length = SEQ_STEP_COUNT;
+  p->step_mask = 0xFFFF;
+  p->motion_slot_param[0].motion_enable = 1;
+  p->motion_slot_param[0].smooth_enable = 1;
+  p->motion_slot_param[0].parameter_id = 18; //VCO1 SHAPE
+  p->motion_slot_step_mask[0] = 0xFFFF;
+  for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
+    mnlg_step_event_data_t *s = &p->step_event_data[i];
+    for (uint32_t j = 0; j < MNLG_POLY; j++) {
+      s->note[j] = STEP_NOTE(i) + j * 4;
+      s->velocity[j] = j < 1 + (i & 3) ? 100 : 0;
+      s->gate[j].gate_time = 36 + (i & 3) * 8;
+    }
+    s->motion_slot_data[0][0] = i * 16;
+    s->motion_slot_data[0][1] = i * 16 + 8;
+  }
+  return sizeof(*p);
+}
+
+static size_t molg_prog(uint8_t *data) {
+  molg_prog_t *p = (molg_prog_t *)data;
+  memset(p, 0, sizeof(*p));
+  p->PROG = MARK_PROG;
+  snprintf(p->name, sizeof(p->name), "MOLG SEQ");
+  p->vco1_pitch_hi = PITCH_CENTER >> 2;
+  p->vco2_pitch_hi = (PITCH_CENTER + 20) >> 2;
+  p->vco1_shape_hi = 96;
+  p->vco2_shape_hi = 32;
+  p->vco1_level_hi = LEVEL_MAX >> 2;
+  p->vco2_level_hi = 160;
+  p->vco1_octave = 1;
+  p->vco1_wave = wave_saw;
+  p->vco2_octave = 1;
+  p->vco2_wave = wave_tri;
+  p->ring_sync = 2;
+  p->keyboard_octave = 2;
+  p->bend_range_pos = 2;
+  p->bend_range_neg = 2;
+  p->program_level = 102;
+  p->SEQD = MARK_SEQD;
+  p->bpm = 1400;
+  p->step_length = SEQ_STEP_COUNT;
+  p->step_mask = 0xEEEE;
+  for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
+    molg_step_event_data_t *s = &p->step_event_data[i];
+    s->note = STEP_NOTE(i);
+    s->velocity = 100;
+    s->gate.gate_time = i == 7 ? 72 : 30;
+  }
+  return sizeof(*p);
+}
+
+static size_t mnlgxd_prog(uint8_t *data) {
+  mnlgxd_prog_t *p = (mnlgxd_prog_t *)data;
+  memset(p, 0, sizeof(*p));
+  p->PROG = MARK_PROG;
+  snprintf(p->name, sizeof(p->name), "MNLGXD SEQ");
+  p->keyboard_octave = 2;
+  p->vco1_wave = wave_tri;
+  p->vco1_octave = 1;
+  p->vco1_pitch = PITCH_CENTER;
+  p->vco1_shape = 300;
+  p->vco2_wave = wave_saw;
+  p->vco2_octave = 1;
+  p->vco2_pitch = PITCH_CENTER + 10;
+  p->vco2_shape = 600;
+  p->sync = 1;
+  p->ring = 1;
+  p->cross_mod_depth = 200;
+  p->multi_type = multi_noise;
+  p->multi_octave = 1;
+  p->noise_shape = 512;
+  p->vco1_level = LEVEL_MAX;
+  p->vco2_level = 700;
+  p->multi_level = 64;
+  p->bend_range_pos = 2;
+  p->bend_range_neg = 2;
+  p->program_level = 100;
+  p->PRED = MARK_PRED;
+  p->SEQD = MARK_SEQD;
+  p->bpm = 1000;
+  p->step_length = SEQ_STEP_COUNT;
+  p->step_resolution = 1;
+  p->step_mask = 0xFFFF;
+  for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
+    mnlgxd_step_event_data_t *s = &p->step_event_data[i];
+    for (uint32_t j = 0; j < MNLGXD_POLY; j++) {
+      s->note[j] = STEP_NOTE(i) + j * 3;
+      s->velocity[j] = j < 1 + (i & 7) ? 100 : 0;
+      s->gate[j].gate_time = 50;
+    }
+  }
+  return sizeof(*p);
+}
+
+size_t fixture_anthologue(uint8_t *data, size_t size) {
+  size_t len = 0;
+  if (size < sizeof(logue_prog))
+    return 0;
+  memset(data, 0, sizeof(logue_prog));
+  len += mnlg_prog(data + len);
+  len += molg_prog(data + len);
+  len += prlg_prog(data + len, timbre_split);
+  len += prlg_prog(data + len, timbre_xfade);
+  len += mnlgxd_prog(data + len);
+  return len;
+}
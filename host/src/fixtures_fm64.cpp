@@ -0,0 +1,91 @@
+/*
+ * File: fixtures_fm64.cpp
+ *
+ * Synthetic DX7/DX11 voice banks.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "fixtures.h"
+#include "osc_host.h"
+#include "../../src/fm64.h"
+
+static void dx7_voice(dx7_voice_t *v, uint32_t n) {
+  memset(v, 0, sizeof(*v));
+  for (uint32_t i = 0; i < DX7_OPERATOR_COUNT; i++) {
+    dx7_operator_t *op = &v->op[i];
+    op->r[0] = 95 - i * 3;
+    op->r[1] = 60 + i * 4;
+    op->r[2] = 40;
+    op->r[3] = 70;
+    op->l[0] = 99;
+    op->l[1] = 90 - i * 2;
+    op->l[2] = 80;
+    op->l[3] = 0;
+    op->tl = (dx7_algorithm[n][i] & ALG_OUT_MASK) ? 99 : 70 + ((i + n) & 7) * 3;
+    op->pm = (n & 7) == 7 && i == 0; //occasional fixed frequency operator
+    op->pc = 1 + ((i + n) % 4);
+    op->pf = (i * 7) & 0x1F;
+  }
+  for (uint32_t j = 0; j < DX7_PEG_STAGE_COUNT; j++) {
+    v->pr[j] = 99;
+    v->pl[j] = PEG_CENTER;
+  }
+  if ((n & 3) == 1) { //pitch sweep down from above to the center
+    v->pr[0] = 90;
+    v->pr[1] = 55;
+    v->pl[0] = 70;
+    v->pl[1] = 45;
+  }
+  v->als = n;
+  v->fbl = n & 7;
+  v->opi = 1;
+  v->trnp = TRANSPOSE_CENTER;
+  snprintf(v->vnam, sizeof(v->vnam), "DX7 ALG%02u", n + 1);
+}
+
+static void dx11_voice(dx11_voice_t *v, uint32_t n) {
+  memset(v, 0, sizeof(*v));
+  for (uint32_t i = 0; i < DX11_OPERATOR_COUNT; i++) {
+    dx11_operator_t *op = &v->op[i];
+    op->r[0] = 31 - i;
+    op->r[1] = 20;
+    op->r[2] = 10;
+    op->r[3] = 8;
+    op->d1l = 12;
+    op->out = 99 - i * 5;
+    op->f = 4 + i * 4;
+    v->opadd[i].osw = (n + i) & 7;
+  }
+  for (uint32_t j = 0; j < DX11_PEG_STAGE_COUNT; j++) {
+    v->pr[j] = 99;
+    v->pl[j] = PEG_CENTER;
+  }
+  if (n & 1) { //pitch rise from below
+    v->pr[0] = 60;
+    v->pl[2] = 30;
+  }
+  v->alg = n;
+  v->fbl = (n + 3) & 7;
+  v->trps = TRANSPOSE_CENTER;
+  snprintf(v->vnam, sizeof(v->vnam), "DX11 ALG%u", n + 1);
+}
+
+size_t fixture_fm64(uint8_t *data, size_t size) {
+  const size_t bank_size = BANK_SIZE * sizeof(dx_voices[0][0]);
+  if (size < bank_size * BANK_COUNT)
+    return 0;
+  memset(data, 0, bank_size * BANK_COUNT);
+  for (uint32_t i = 0; i < BANK_SIZE; i++)
+    dx7_voice((dx7_voice_t *)(data + FIXTURE_FM64_DX7_BANK * bank_size + i * sizeof(dx_voices[0][0])), i);
+//DX11 voice name lays beyond DX7 voice name, so the rest of the bank is left empty
+  for (uint32_t i = 0; i < FIXTURE_FM64_DX11_COUNT; i++)
+    dx11_voice((dx11_voice_t *)(data + FIXTURE_FM64_DX11_BANK * bank_size + i * sizeof(dx_voices[0][0])), i);
+  return bank_size * BANK_COUNT;
+}
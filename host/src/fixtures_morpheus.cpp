@@ -0,0 +1,51 @@
+/*
+ * File: fixtures_morpheus.cpp
+ *
+ * Synthetic u-law wave bank.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "fixtures.h"
+#include "osc_host.h"
+
+#define SAMPLE_COUNT 256
+#define WAVE_COUNT 64
+
+#define ULAW_BIAS 0x84
+#define ULAW_CLIP 32635
+
+static uint8_t to_ulaw(int16_t x) {
+  uint8_t sign = 0;
+  int32_t v = x;
+  if (v < 0) {
+    v = -v;
+    sign = 0x80;
+  }
+  if (v > ULAW_CLIP)
+    v = ULAW_CLIP;
+  v += ULAW_BIAS;
+  uint8_t exp = 7;
+  for (int32_t mask = 0x4000; !(v & mask) && exp; mask >>= 1, exp--);
+  return ~(sign | (exp << 4) | ((v >> (exp + 3)) & 0x0F));
+}
+
+size_t fixture_morpheus(uint8_t *data, size_t size) {
+  if (size < SAMPLE_COUNT * WAVE_COUNT)
+    return 0;
+//pulse width and harmonic content sweep across the bank
+  for (uint32_t j = 0; j < WAVE_COUNT; j++) {
+    for (uint32_t i = 0; i < SAMPLE_COUNT; i++) {
+      float y = 0.f;
+      for (uint32_t k = 1; k <= 1 + (j >> 2); k++)
+        y += sinf(2.f * M_PI * k * i / SAMPLE_COUNT + j * .1f * k) / k;
+      data[j * SAMPLE_COUNT + i] = to_ulaw((int16_t)(y * 16384.f));
+    }
+  }
+  return SAMPLE_COUNT * WAVE_COUNT;
+}
@@ -0,0 +1,375 @@
+/*
+ * File: golden.cpp
+ *
+ * Golden render regression harness.
+ *
+ * Plays fixed note/parameter scripts through the oscillator hooks
+ * and compares the rendered output against reference renders in
+ * host/golden. Fixed point oscillators must match bit-exactly,
+ * floating point ones within the script error level tolerance
+ * relative to the reference signal.
+ *
+ * Scripts run with the nutekt-digital init, the ones with a platform
+ * suffix are replayed with a logue platform init to cover its budgets.
+ *
+ * Usage: osc_golden [-u] [-l libdir] [-g goldendir] [filter]
+ *   -u  update reference renders instead of comparing
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <libgen.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "osc_host.h"
+#include "fixtures.h"
+
+#define SAMPLES_MAX 0x8000
+#define DATA_SIZE_MAX 0x10000
+#define DEFAULT_BPM 1200
+
+#define EXACT 0 //bit-exact compare
+#define TOLERANCE_FLOAT -90.f //error level relative to reference, dB
+
+#define PARAM_MAX 1023
+#define P_BPM 6 //Anthologue BPM assignable controller
+#define P_VCO1_SHAPE 10 //Anthologue VCO1 shape assignable controller
+
+struct script_t {
+  osc_host_t osc;
+  user_osc_param_t params;
+  uint32_t frames; //frames per cycle
+  uint32_t len;
+  int32_t out[SAMPLES_MAX];
+};
+
+struct golden_t {
+  const char *osc;
+  const char *name;
+  float tolerance;
+  size_t (*fixture)(uint8_t *data, size_t size);
+  void (*play)(script_t *s);
+  uint32_t platform; //init platform argument
+};
+
+static uint8_t s_data[DATA_SIZE_MAX];
+
+static void param(script_t *s, uint16_t index, uint16_t value) {
+  s->osc.param(index, value);
+}
+
+static void noteon(script_t *s, uint8_t note) {
+  s->params.pitch = note << 8;
+  s->osc.noteon(&s->params);
+}
+
+static void noteoff(script_t *s) {
+  s->osc.noteoff(&s->params);
+}
+
+static void render(script_t *s, uint32_t frames) {
+  if (frames > SAMPLES_MAX - s->len)
+    frames = SAMPLES_MAX - s->len;
+  for (uint32_t f; frames; frames -= f, s->len += f) {
+    f = frames < s->frames ? frames : s->frames;
+    s->osc.cycle(&s->params, &s->out[s->len], f);
+  }
+}
+
+static void fm64_dx7_voices(script_t *s) {
+  param(s, k_user_osc_param_id2, FIXTURE_FM64_DX7_BANK);
+  for (uint32_t v = 0; v < FIXTURE_FM64_DX7_COUNT; v++) {
+    param(s, k_user_osc_param_id1, v);
+    noteon(s, 36 + (v * 7) % 48);
+    render(s, 384);
+    noteoff(s);
+    render(s, 128);
+  }
+}
+
+static void fm64_dx11_voices(script_t *s) {
+  param(s, k_user_osc_param_id2, FIXTURE_FM64_DX11_BANK);
+  for (uint32_t v = 0; v < FIXTURE_FM64_DX11_COUNT; v++) {
+    param(s, k_user_osc_param_id1, v);
+    noteon(s, 48 + v * 3);
+    render(s, 768);
+    noteoff(s);
+    render(s, 256);
+  }
+}
+
+static void fm64_params(script_t *s) {
+  s->frames = 37;
+  param(s, k_user_osc_param_id2, FIXTURE_FM64_DX7_BANK);
+  param(s, k_user_osc_param_id1, 4);
+  param(s, k_user_osc_param_id3, 0); //feedback
+  param(s, k_user_osc_param_id4, 19); //op5 level
+  noteon(s, 57);
+  for (uint32_t i = 0; i < 8; i++) {
+    param(s, k_user_osc_param_shape, i * 146);
+    param(s, k_user_osc_param_shiftshape, PARAM_MAX - i * 128);
+    render(s, 512);
+  }
+  param(s, k_user_osc_param_id5, 31); //algorithm override
+  noteon(s, 69);
+  s->params.pitch += 0x80; //pitch bend between notes
+  render(s, 2048);
+  noteoff(s);
+  render(s, 2048);
+}
+
+static void fm64_poly(script_t *s) {
+  param(s, k_user_osc_param_id2, FIXTURE_FM64_DX7_BANK);
+  param(s, k_user_osc_param_id1, 1);
+  param(s, k_user_osc_param_id6, 3); //4 voices, 3 within the NTS-1 budget
+  noteon(s, 48);
+  noteon(s, 52);
+  noteon(s, 55);
+  render(s, 1024);
+  noteon(s, 60); //steals 48
+  noteon(s, 64); //steals 52
+  s->params.pitch += 0x80; //pitch bend applies to all notes
+  render(s, 1024);
+  noteon(s, 55); //retrigger
+  render(s, 512);
+  param(s, k_user_osc_param_id6, 1); //2 voices, the oldest are dropped
+  render(s, 512);
+  noteoff(s);
+  render(s, 1024);
+  param(s, k_user_osc_param_id2, FIXTURE_FM64_DX11_BANK);
+  param(s, k_user_osc_param_id6, 3);
+  noteon(s, 45);
+  noteon(s, 57);
+  noteon(s, 64);
+  render(s, 1536);
+  noteoff(s);
+  render(s, 512);
+}
+
+static void anthologue_note(script_t *s) {
+  for (uint32_t p = 0; p < fixture_prog_num; p++) {
+    param(s, k_user_osc_param_id1, p);
+    param(s, k_user_osc_param_id3, 0);
+    noteon(s, 48 + p * 5);
+    render(s, 1024);
+    s->params.pitch += 0x40;
+    render(s, 576);
+  }
+}
+
+static void anthologue_seq(script_t *s) {
+  static const uint8_t progs[] = {fixture_prog_mnlg, fixture_prog_molg, fixture_prog_mnlgxd};
+  param(s, k_user_osc_param_id4, P_BPM);
+  for (uint32_t i = 0; i < sizeof(progs); i++) {
+    param(s, k_user_osc_param_id1, progs[i]);
+    param(s, k_user_osc_param_id3, 1);
+    param(s, k_user_osc_param_shape, PARAM_MAX); //600 BPM
+    noteon(s, 60);
+    render(s, 7200);
+  }
+  osc_host_set_bpm(4000);
+  param(s, k_user_osc_param_id3, 2); //NTS-1 BPM
+  noteon(s, 62);
+  render(s, 4800);
+  osc_host_set_bpm(0); //stopped clock holds the step
+  render(s, 1200);
+}
+
+static void anthologue_blep(script_t *s) {
+  param(s, k_user_osc_param_id6, 1);
+  for (uint32_t p = 0; p < fixture_prog_num; p++) {
+    param(s, k_user_osc_param_id1, p);
+    param(s, k_user_osc_param_id3, 0);
+    noteon(s, 72 + p * 5);
+    render(s, 1024);
+  }
+  param(s, k_user_osc_param_id1, fixture_prog_mnlg);
+  param(s, k_user_osc_param_id4, P_VCO1_SHAPE);
+  noteon(s, 91);
+  for (uint32_t i = 0; i <= 4; i++) {
+    param(s, k_user_osc_param_shape, PARAM_MAX * i / 4);
+    render(s, 512);
+  }
+}
+
+static void saw_chord(script_t *s) {
+  param(s, k_user_osc_param_id1, 11);
+  param(s, k_user_osc_param_id2, 30);
+  param(s, k_user_osc_param_id6, 2);
+  param(s, k_user_osc_param_shape, PARAM_MAX);
+  param(s, k_user_osc_param_shiftshape, 300);
+  noteon(s, 48);
+  noteon(s, 52);
+  noteon(s, 55);
+  render(s, 2048);
+  param(s, k_user_osc_param_shape, 500); //fractional unison
+  s->params.shape_lfo = 0x20000000;
+  render(s, 2048);
+  noteoff(s);
+  param(s, k_user_osc_param_id6, 0);
+  noteon(s, 60);
+  render(s, 1024);
+}
+
+static void morpheus_modes(script_t *s) {
+  param(s, k_user_osc_param_id2, 1); //LFO X saw
+  param(s, k_user_osc_param_id3, 3); //LFO Y triangle
+  param(s, k_user_osc_param_shape, 700);
+  param(s, k_user_osc_param_shiftshape, 600);
+  for (uint32_t i = 0; i < 4; i++) {
+    param(s, k_user_osc_param_id1, i >> 1);
+    param(s, k_user_osc_param_id5, i & 1);
+    noteon(s, 45 + i * 7);
+    render(s, 2048);
+  }
+}
+
+static const golden_t s_golden[] = {
+  {"FM64", "dx7_voices", EXACT, fixture_fm64, fm64_dx7_voices, k_user_target_nutektdigital},
+  {"FM64", "dx11_voices", EXACT, fixture_fm64, fm64_dx11_voices, k_user_target_nutektdigital},
+  {"FM64", "params", EXACT, fixture_fm64, fm64_params, k_user_target_nutektdigital},
+  {"FM64", "poly", EXACT, fixture_fm64, fm64_poly, k_user_target_nutektdigital},
+  {"FM64", "poly_prologue", EXACT, fixture_fm64, fm64_poly, k_user_target_prologue}, //single voice budget
+  {"Anthologue", "note", EXACT, fixture_anthologue, anthologue_note, k_user_target_nutektdigital},
+  {"Anthologue", "seq", EXACT, fixture_anthologue, anthologue_seq, k_user_target_nutektdigital},
+  {"Anthologue", "seq_prologue", EXACT, fixture_anthologue, anthologue_seq, k_user_target_prologue}, //half the step voices
+  {"Anthologue", "blep", EXACT, fixture_anthologue, anthologue_blep, k_user_target_nutektdigital},
+  {"FastSaw", "chord", EXACT, NULL, saw_chord, k_user_target_nutektdigital},
+  {"FastSaw", "chord_miniloguexd", EXACT, NULL, saw_chord, k_user_target_miniloguexd},
+  {"Supersaw", "chord", TOLERANCE_FLOAT, NULL, saw_chord, k_user_target_nutektdigital},
+  {"Supersaw", "chord_prologue", TOLERANCE_FLOAT, NULL, saw_chord, k_user_target_prologue},
+  {"Morpheus", "modes", TOLERANCE_FLOAT, fixture_morpheus, morpheus_modes, k_user_target_nutektdigital},
+  {"Morpheus", "modes_miniloguexd", TOLERANCE_FLOAT, fixture_morpheus, morpheus_modes, k_user_target_miniloguexd},
+};
+
+#define GOLDEN_COUNT (sizeof(s_golden) / sizeof(s_golden[0]))
+
+static int play(const char *libdir, const golden_t *g, script_t *s) {
+  char path[PATH_MAX];
+
+  snprintf(path, sizeof(path), "%s/lib%s.so", libdir, g->osc);
+  if (osc_host_open(&s->osc, path))
+    return -1;
+  osc_host_seed(0);
+  osc_host_set_bpm(DEFAULT_BPM);
+  if (g->fixture)
+    osc_host_inject(&s->osc, OSC_HOST_PAYLOAD_OFFSET, s_data, g->fixture(s_data, sizeof(s_data)));
+  memset(&s->params, 0, sizeof(s->params));
+  s->frames = OSC_HOST_FRAMES_MAX;
+  s->len = 0;
+  s->osc.init(g->platform, 0);
+//the runtime sends all parameters after init, bank/sub selectors go before voice/program
+  for (uint32_t index = k_num_user_osc_param_id; index--;)
+    s->osc.param(index, 0);
+  g->play(s);
+  osc_host_close(&s->osc);
+  return 0;
+}
+
+//error level relative to reference, dB
+static float error_db(const int32_t *ref, const int32_t *out, uint32_t len) {
+  double sig = 0., err = 0.;
+  for (uint32_t i = 0; i < len; i++) {
+    const double d = (double)out[i] - ref[i];
+    sig += (double)ref[i] * ref[i];
+    err += d * d;
+  }
+  if (err == 0.)
+    return -INFINITY;
+  return 10. * log10(err / (sig > 0. ? sig : 1.));
+}
+
+static int check(const char *path, const golden_t *g, const script_t *s) {
+  static int32_t ref[SAMPLES_MAX];
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    printf("FAIL %s/%s: no reference render %s\n", g->osc, g->name, path);
+    return 1;
+  }
+  const uint32_t len = fread(ref, sizeof(*ref), SAMPLES_MAX, f);
+  fclose(f);
+  if (len != s->len) {
+    printf("FAIL %s/%s: length %u, expected %u\n", g->osc, g->name, s->len, len);
+    return 1;
+  }
+  const float db = error_db(ref, s->out, len);
+  if (g->tolerance == EXACT) {
+    uint32_t i, n = 0;
+    for (i = 0; i < len && ref[i] == s->out[i]; i++);
+    if (i < len) {
+      for (uint32_t j = i; j < len; n += ref[j] != s->out[j], j++);
+      printf("FAIL %s/%s: %u samples differ from #%u, error %.1fdB\n", g->osc, g->name, n, i, db);
+      return 1;
+    }
+  } else if (db > g->tolerance) {
+    printf("FAIL %s/%s: error %.1fdB, tolerance %.1fdB\n", g->osc, g->name, db, g->tolerance);
+    return 1;
+  }
+  printf("OK   %s/%s\n", g->osc, g->name);
+  return 0;
+}
+
+static int update(const char *path, const golden_t *g, const script_t *s) {
+  FILE *f = fopen(path, "wb");
+  if (f == NULL || fwrite(s->out, sizeof(*s->out), s->len, f) != s->len) {
+    perror(path);
+    if (f)
+      fclose(f);
+    return 1;
+  }
+  fclose(f);
+  printf("UPD  %s/%s: %u samples\n", g->osc, g->name, s->len);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  static script_t s;
+  const char *libdir = dirname(strdup(argv[0]));
+  const char *goldendir = NULL;
+  const char *filter = NULL;
+  char path[PATH_MAX];
+  bool bless = false;
+  int opt, fails = 0;
+
+  while ((opt = getopt(argc, argv, "ul:g:")) != -1) {
+    switch (opt) {
+      case 'u':
+        bless = true;
+        break;
+      case 'l':
+        libdir = optarg;
+        break;
+      case 'g':
+        goldendir = optarg;
+        break;
+      default:
+        fprintf(stderr, "Usage: %s [-u] [-l libdir] [-g goldendir] [filter]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind < argc)
+    filter = argv[optind];
+  if (goldendir == NULL) {
+    snprintf(path, sizeof(path), "%s/../golden", libdir);
+    goldendir = strdup(path);
+  }
+
+  for (uint32_t i = 0; i < GOLDEN_COUNT; i++) {
+    const golden_t *g = &s_golden[i];
+    snprintf(path, sizeof(path), "%s/%s", g->osc, g->name);
+    if (filter && !strstr(path, filter))
+      continue;
+    if (play(libdir, g, &s))
+      return 1;
+    snprintf(path, sizeof(path), "%s/%s_%s.q31", goldendir, g->osc, g->name);
+    fails += bless ? update(path, g, &s) : check(path, g, &s);
+  }
+  return fails ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * File: logue.cpp
+ *
+ * Host stand-in for logue-sdk firmware runtime.
+ *
+ * Generates the runtime LUTs on load and provides white noise,
+ * tempo and cycle counter sources. Noise is a deterministic xorshift
+ * and the cycle counter is stopped unless set, so that renders are
+ * reproducible. Wave bank contents are synthetic,
+ * only their layout matches the firmware.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <math.h>
+#include <time.h>
+
+#include "osc_api.h"
+#include "fx_api.h"
+#include "osc_host.h"
+
+#define NOISE_SEED 0x12345678
+#define DEFAULT_BPM 1200
+
+#define WAVES_A_FIRST 0
+#define WAVES_B_FIRST (WAVES_A_FIRST + k_waves_a_cnt)
+#define WAVES_C_FIRST (WAVES_B_FIRST + k_waves_b_cnt)
+#define WAVES_D_FIRST (WAVES_C_FIRST + k_waves_c_cnt)
+#define WAVES_E_FIRST (WAVES_D_FIRST + k_waves_d_cnt)
+#define WAVES_F_FIRST (WAVES_E_FIRST + k_waves_e_cnt)
+#define WAVES_TOTAL (WAVES_F_FIRST + k_waves_f_cnt)
+
+static uint32_t s_noise = NOISE_SEED;
+static uint16_t s_bpm = DEFAULT_BPM;
+static double s_cycle_ns; //stopped by default, so renders do not depend on host load
+
+//writable LUT storage, exported read-only under the runtime names
+static float s_midi_to_hz_lut[k_midi_to_hz_size] asm("s_midi_to_hz_lut");
+static float s_wt_sine_lut[k_wt_sine_lut_size] asm("s_wt_sine_lut");
+static float s_wt_saw_lut[k_wt_saw_lut_tsize] asm("s_wt_saw_lut");
+static float s_waves[WAVES_TOTAL][k_waves_lut_size];
+
+extern const float midi_to_hz_lut_f[k_midi_to_hz_size] __attribute__((alias("s_midi_to_hz_lut")));
+extern const float wt_sine_lut_f[k_wt_sine_lut_size] __attribute__((alias("s_wt_sine_lut")));
+extern const float wt_saw_lut_f[k_wt_saw_lut_tsize] __attribute__((alias("s_wt_saw_lut")));
+
+#define W(n) s_waves[n]
+const float * const wavesA[k_waves_a_cnt] = {
+  W(0), W(1), W(2), W(3), W(4), W(5), W(6), W(7), W(8), W(9), W(10), W(11), W(12), W(13), W(14), W(15)
+};
+const float * const wavesB[k_waves_b_cnt] = {
+  W(16), W(17), W(18), W(19), W(20), W(21), W(22), W(23), W(24), W(25), W(26), W(27), W(28), W(29), W(30), W(31)
+};
+const float * const wavesC[k_waves_c_cnt] = {
+  W(32), W(33), W(34), W(35), W(36), W(37), W(38), W(39), W(40), W(41), W(42), W(43), W(44), W(45)
+};
+const float * const wavesD[k_waves_d_cnt] = {
+  W(46), W(47), W(48), W(49), W(50), W(51), W(52), W(53), W(54), W(55), W(56), W(57), W(58)
+};
+const float * const wavesE[k_waves_e_cnt] = {
+  W(59), W(60), W(61), W(62), W(63), W(64), W(65), W(66), W(67), W(68), W(69), W(70), W(71), W(72), W(73)
+};
+const float * const wavesF[k_waves_f_cnt] = {
+  W(74), W(75), W(76), W(77), W(78), W(79), W(80), W(81), W(82), W(83), W(84), W(85), W(86), W(87), W(88), W(89)
+};
+#undef W
+
+static_assert(WAVES_TOTAL == 90, "wave bank pointer tables are out of sync");
+
+static void normalize(float *lut, uint32_t size) {
+  float peak = 0.f;
+  for (uint32_t i = size; i--;)
+    if (fabsf(lut[i]) > peak)
+      peak = fabsf(lut[i]);
+  if (peak > 0.f)
+    for (uint32_t i = size; i--; lut[i] /= peak);
+}
+
+__attribute__((constructor))
+static void logue_init() {
+  for (uint32_t i = k_midi_to_hz_size; i--;)
+    s_midi_to_hz_lut[i] = 440.f * powf(2.f, ((float)i - 69.f) / 12.f);
+
+//half period stored
+  for (uint32_t i = k_wt_sine_lut_size; i--;)
+    s_wt_sine_lut[i] = sinf(M_PI * i / k_wt_sine_size);
+
+//half period stored, harmonics count halved for each next note range
+  for (uint32_t j = k_wt_saw_notes_cnt; j--;) {
+    float *lut = &s_wt_saw_lut[j * k_wt_saw_lut_size];
+    for (uint32_t i = k_wt_saw_lut_size; i--;) {
+      lut[i] = 0.f;
+      for (uint32_t k = 1 << (k_wt_saw_notes_cnt - 1 - j); k; k--)
+        lut[i] += sinf(M_PI * k * i / k_wt_saw_size) / k;
+    }
+    normalize(lut, k_wt_saw_lut_size);
+  }
+
+//synthetic harmonic series, varying by wave number
+  for (uint32_t j = WAVES_TOTAL; j--;) {
+    float *lut = s_waves[j];
+    const float slope = 1.f + (j & 3) * .5f;
+    for (uint32_t i = k_waves_lut_size; i--;) {
+      lut[i] = 0.f;
+      for (uint32_t k = 1 + (j >> 2); k; k--)
+        lut[i] += ((k & 1) ? 1.f : (j & 4) ? -1.f : 0.f) * sinf(2.f * M_PI * k * i / k_waves_size) / powf(k, slope);
+    }
+    normalize(lut, k_waves_lut_size);
+  }
+}
+
+float _osc_white(void) {
+  s_noise ^= s_noise << 13;
+  s_noise ^= s_noise >> 17;
+  s_noise ^= s_noise << 5;
+  return q31_to_f32((q31_t)s_noise);
+}
+
+uint16_t _fx_get_bpm(void) {
+  return s_bpm;
+}
+
+void osc_host_set_bpm(uint16_t bpm) {
+  s_bpm = bpm;
+}
+
+void osc_host_seed(uint32_t seed) {
+  s_noise = seed ? seed : NOISE_SEED;
+}
+
+void osc_host_set_cycle_ns(double ns) {
+  s_cycle_ns = ns;
+}
+
+uint32_t osc_host_cycles(void) {
+  struct timespec ts;
+  if (s_cycle_ns <= 0.)
+    return 0;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(uint64_t)((ts.tv_sec * 1e9 + ts.tv_nsec) / s_cycle_ns);
+}
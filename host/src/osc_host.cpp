@@ -0,0 +1,101 @@
+/*
+ * File: osc_host.cpp
+ *
+ * Oscillator library loader.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "osc_host.h"
+
+#define HOOKS_SECTION ".hooks"
+
+//locate custom data section in the library file and map it to the loaded image
+static int find_hooks(osc_host_t *osc, const char *path) {
+  FILE *f;
+  ElfW(Ehdr) eh;
+  ElfW(Shdr) sh, strsh;
+  char name[sizeof(HOOKS_SECTION)];
+  struct link_map *lm;
+  int res = -1;
+
+  osc->data = NULL;
+  osc->data_size = 0;
+  if (dlinfo(osc->handle, RTLD_DI_LINKMAP, &lm) || (f = fopen(path, "rb")) == NULL)
+    return -1;
+  if (fread(&eh, sizeof(eh), 1, f) == 1
+    && fseek(f, eh.e_shoff + eh.e_shstrndx * eh.e_shentsize, SEEK_SET) == 0
+    && fread(&strsh, sizeof(strsh), 1, f) == 1
+  ) {
+    for (uint32_t i = 0; i < eh.e_shnum; i++) {
+      if (fseek(f, eh.e_shoff + i * eh.e_shentsize, SEEK_SET) || fread(&sh, sizeof(sh), 1, f) != 1)
+        break;
+      if (fseek(f, strsh.sh_offset + sh.sh_name, SEEK_SET) || fread(name, sizeof(name), 1, f) != 1)
+        continue;
+      if (memcmp(name, HOOKS_SECTION, sizeof(name)) == 0) {
+        osc->data = (uint8_t *)(lm->l_addr + sh.sh_addr);
+        osc->data_size = sh.sh_size;
+        res = 0;
+        break;
+      }
+    }
+  }
+  fclose(f);
+  return res;
+}
+
+int osc_host_open(osc_host_t *osc, const char *path) {
+  memset(osc, 0, sizeof(*osc));
+  if ((osc->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+    fprintf(stderr, "%s\n", dlerror());
+    return -1;
+  }
+  *(void **)&osc->init = dlsym(osc->handle, "_hook_init");
+  *(void **)&osc->cycle = dlsym(osc->handle, "_hook_cycle");
+  *(void **)&osc->noteon = dlsym(osc->handle, "_hook_on");
+  *(void **)&osc->noteoff = dlsym(osc->handle, "_hook_off");
+  *(void **)&osc->param = dlsym(osc->handle, "_hook_param");
+  osc->perf = (const struct perf_ring_t *)dlsym(osc->handle, "perf_ring");
+  if (!osc->init || !osc->cycle || !osc->noteon || !osc->noteoff || !osc->param) {
+    fprintf(stderr, "%s: missing oscillator hooks\n", path);
+    osc_host_close(osc);
+    return -1;
+  }
+  if (find_hooks(osc, path) == 0 && osc->data_size) {
+//the section is read-only in the image, the injectors patch it in place
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t start = (uintptr_t)osc->data & ~(page - 1);
+    const uintptr_t end = ((uintptr_t)osc->data + osc->data_size + page - 1) & ~(page - 1);
+    if (mprotect((void *)start, end - start, PROT_READ | PROT_WRITE))
+      osc->data_size = 0;
+  }
+  return 0;
+}
+
+void osc_host_close(osc_host_t *osc) {
+  if (osc->handle)
+    dlclose(osc->handle);
+  memset(osc, 0, sizeof(*osc));
+}
+
+size_t osc_host_inject(osc_host_t *osc, size_t offset, const void *src, size_t size) {
+  if (offset < OSC_HOST_PAYLOAD_OFFSET)
+    return 0;
+  offset -= OSC_HOST_PAYLOAD_OFFSET;
+  if (offset >= osc->data_size)
+    return 0;
+  if (size > osc->data_size - offset)
+    size = osc->data_size - offset;
+  memcpy(osc->data + offset, src, size);
+  return size;
+}
@@ -0,0 +1,68 @@
+/*
+ * File: render.cpp
+ *
+ * Render a single note through a host oscillator library
+ * to raw 32-bit signed 48kHz mono PCM on stdout.
+ *
+ * Usage: osc_render <library> [note] [frames] [data file] [param=value ...]
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osc_host.h"
+
+#define DATA_SIZE_MAX 0x10000
+
+int main(int argc, char **argv) {
+  osc_host_t osc;
+  user_osc_param_t params = {};
+  int32_t buf[OSC_HOST_FRAMES_MAX];
+  uint32_t frames = k_samplerate;
+  int i = 4;
+
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <library> [note] [frames] [data file] [param=value ...]\n", argv[0]);
+    return 1;
+  }
+  if (osc_host_open(&osc, argv[1]))
+    return 1;
+  params.pitch = (argc > 2 ? atoi(argv[2]) : 60) << 8;
+  if (argc > 3)
+    frames = atoi(argv[3]);
+  if (argc > 4 && argv[4][0] != '-' && !strchr(argv[4], '=')) {
+    static uint8_t data[DATA_SIZE_MAX];
+    FILE *f = fopen(argv[4], "rb");
+    if (f == NULL) {
+      perror(argv[4]);
+      return 1;
+    }
+    osc_host_inject(&osc, OSC_HOST_PAYLOAD_OFFSET, data, fread(data, 1, sizeof(data), f));
+    fclose(f);
+    i++;
+  }
+//custom data is in place before init on the target
+  osc.init(k_user_target_nutektdigital, 0);
+//the runtime sends all parameters after init, bank/sub selectors go before voice/program
+  for (uint32_t index = k_num_user_osc_param_id; index--;)
+    osc.param(index, 0);
+  for (; i < argc; i++) {
+    uint32_t index, value;
+    if (sscanf(argv[i], "%u=%u", &index, &value) == 2)
+      osc.param(index, value);
+  }
+  osc.noteon(&params);
+  for (uint32_t f; frames; frames -= f) {
+    f = frames < OSC_HOST_FRAMES_MAX ? frames : OSC_HOST_FRAMES_MAX;
+    osc.cycle(&params, buf, f);
+    fwrite(buf, sizeof(*buf), f, stdout);
+  }
+  osc.noteoff(&params);
+  osc_host_close(&osc);
+  return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * File: exp2q.h
+ *
+ * Fixed point exp2 lookup.
+ *
+ * Exponents are Q31 scaled by 1/32,
+ * covering [-32.0, 32.0) range.
+ *
+ * Optional definitions:
+ * - EXP2Q_LUT_SIZE_EXP: LUT size as power of 2, 8 (256 entries) by default
+ *
+ * Also single invocation of exp2_initq()
+ * is required to generate the LUT.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include "float_math.h"
+#include "fixed_mathq.h"
+
+#ifndef EXP2Q_LUT_SIZE_EXP
+#define EXP2Q_LUT_SIZE_EXP 8
+#endif
+#define k_exp2q_lut_size (1 << EXP2Q_LUT_SIZE_EXP)
+
+#define k_exp2q_a4_w0 -0x1B13DA34 // log2(440/48000)/32
+#define k_exp2q_semitone 0x00555555 // 1/12/32
+
+q31_t exp2_lut_q[k_exp2q_lut_size + 1]; //2^x/2 for x in [0, 1.0]
+
+  /**
+   * Fixed point 2^x
+   *
+   * @param   x  Exponent scaled by 1/32
+   * @return     2^(x*32), saturated to [0, 1.0)
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t pow2q(q31_t x) {
+  const int32_t n = x >> 26;
+  const q31_t fr = (x << 5) & 0x7FFFFFFF;
+  const uint32_t x0 = fr >> (31 - EXP2Q_LUT_SIZE_EXP);
+  if (n >= 0)
+    return 0x7FFFFFFF;
+  return linintq((fr << EXP2Q_LUT_SIZE_EXP) & 0x7FFFFFFF, exp2_lut_q[x0], exp2_lut_q[x0 + 1]) >> (-n - 1);
+}
+
+  /**
+   * Get Q31 phase increment for given note and fine modulation
+   *
+   * @param note Note in [0-151] range, mod in [0.0-1.0) range.
+   * @return     Corresponding [0.0-1.0) phase increment in Q31, exponential between semitones.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t osc_w0q_for_note_exp2(uint8_t note, q31_t mod) {
+  return pow2q(k_exp2q_a4_w0 + ((int32_t)note - 69) * k_exp2q_semitone + q31mul(mod, k_exp2q_semitone));
+}
+
+  /**
+   * Fixed point lookup tables precalculation.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void exp2_initq() {
+  for (uint32_t i = k_exp2q_lut_size + 1; i--;)
+    exp2_lut_q[i] = f32_to_q31(.5f * powf(2.f, (float)i / k_exp2q_lut_size));
+}
@@ -0,0 +1,141 @@
+/*
+ * File: governor.h
+ *
+ * Adaptive CPU governor.
+ *
+ * Measures OSC_CYCLE cycles per block and steps the oscillator quality
+ * level down as soon as a block takes more than the budget. The level
+ * is stepped back up only after a number of blocks in a row leave enough
+ * headroom. Level 0 is the full quality, the oscillator decides what
+ * each next level trades off.
+ *
+ * Cycles are counted with DWT CYCCNT on the target and with
+ * osc_host_cycles() of the host runtime in the host build.
+ *
+ * Optional definitions:
+ * - GOVERNOR_BUDGET: OSC_CYCLE budget in percent of the platform cycles per sample, 50 by default
+ * - GOVERNOR_HEADROOM: load in percent of the budget to step the level back up, 60 by default
+ * - GOVERNOR_HOLD: blocks with enough headroom to step the level back up, 256 by default
+ * - GOVERNOR_DISABLE: keep the full quality level
+ *
+ * Also single invocation of governor_init()
+ * is required at OSC_INIT.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "osc_api.h"
+#ifndef __arm__
+#include "osc_host.h"
+#endif
+
+#ifndef GOVERNOR_BUDGET
+#define GOVERNOR_BUDGET 50
+#endif
+#ifndef GOVERNOR_HEADROOM
+#define GOVERNOR_HEADROOM 60
+#endif
+#ifndef GOVERNOR_HOLD
+#define GOVERNOR_HOLD 256 //about .35s with 64 frames per block
+#endif
+
+#define GOVERNOR_CLOCK_NTS1 180000000
+#define GOVERNOR_CLOCK_LOGUE 84000000 //prologue, minilogue xd
+
+#ifdef __arm__
+#define GOVERNOR_DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define GOVERNOR_DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define GOVERNOR_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define GOVERNOR_DEMCR_TRCENA 0x01000000
+#define GOVERNOR_DWT_CYCCNTENA 0x00000001
+#endif
+
+typedef struct {
+  uint32_t start;
+  uint32_t budget; //cycles per sample
+  uint32_t headroom; //cycles per sample
+  uint32_t hold;
+  uint32_t level;
+  uint32_t max_level;
+} governor_t;
+
+static governor_t s_governor;
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+uint32_t governor_cycles() {
+#ifdef __arm__
+  return GOVERNOR_DWT_CYCCNT;
+#else
+  return osc_host_cycles();
+#endif
+}
+
+  /**
+   * Initialize the governor and start the cycle counter
+   *
+   * @param platform   Platform passed to OSC_INIT.
+   * @param max_level  Lowest quality level the oscillator has.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void governor_init(uint32_t platform, uint32_t max_level) {
+  const uint32_t clock = (platform & k_user_target_platform_mask) == k_user_target_nutektdigital ? GOVERNOR_CLOCK_NTS1 : GOVERNOR_CLOCK_LOGUE;
+  s_governor.budget = clock / k_samplerate * GOVERNOR_BUDGET / 100;
+  s_governor.headroom = s_governor.budget * GOVERNOR_HEADROOM / 100;
+  s_governor.hold = 0;
+  s_governor.level = 0;
+  s_governor.max_level = max_level;
+#ifdef __arm__
+  GOVERNOR_DEMCR |= GOVERNOR_DEMCR_TRCENA;
+  GOVERNOR_DWT_CTRL |= GOVERNOR_DWT_CYCCNTENA;
+#endif
+}
+
+  /**
+   * Mark OSC_CYCLE start
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void governor_start() {
+#ifndef GOVERNOR_DISABLE
+  s_governor.start = governor_cycles();
+#endif
+}
+
+  /**
+   * Mark OSC_CYCLE end and update the quality level for the next block
+   *
+   * @param frames  Frames rendered in the block.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void governor_stop(uint32_t frames) {
+#ifndef GOVERNOR_DISABLE
+  const uint32_t cycles = governor_cycles() - s_governor.start;
+  if (cycles > s_governor.budget * frames) {
+    s_governor.hold = 0;
+    if (s_governor.level < s_governor.max_level)
+      s_governor.level++;
+  } else if (cycles < s_governor.headroom * frames) {
+    if (s_governor.level && ++s_governor.hold >= GOVERNOR_HOLD) {
+      s_governor.hold = 0;
+      s_governor.level--;
+    }
+  } else {
+    s_governor.hold = 0;
+  }
+#endif
+}
+
+  /**
+   * Get current quality level
+   *
+   * @return  0 for the full quality, up to max_level.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+uint32_t governor_level() {
+  return s_governor.level;
+}
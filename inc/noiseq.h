@@ -0,0 +1,128 @@
+/*
+ * File: noiseq.h
+ *
+ * Fixed point noise generators.
+ *
+ * 32-bit xorshift white noise taken as Q31 directly, uniform in [-1.0, 1.0).
+ * Pink noise is the white one through the Paul Kellet's economy 3 pole filter,
+ * brown noise is the white one through a leaky integrator. All the variants
+ * share the same generator state and have single sample and block fill calls.
+ *
+ * Also single invocation of noise_initq()
+ * is required to seed the generator.
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include "fixed_mathq.h"
+
+#define k_noiseq_seed 0x92D68CA2
+
+typedef struct {
+  uint32_t x;
+  q31_t pink[3];
+  q31_t brown;
+} noiseq_t;
+
+static noiseq_t s_noiseq;
+
+  /**
+   * Seed the generator and reset the coloured noise filters
+   *
+   * @param seed  Any non-zero value, zero is replaced with k_noiseq_seed.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void noise_initq(uint32_t seed) {
+  s_noiseq.x = seed ? seed : k_noiseq_seed;
+  s_noiseq.pink[0] = 0;
+  s_noiseq.pink[1] = 0;
+  s_noiseq.pink[2] = 0;
+  s_noiseq.brown = 0;
+}
+
+  /**
+   * White noise sample
+   *
+   * @return  Uniform Q31 in [-1.0, 1.0)
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t noise_whiteq() {
+  uint32_t x = s_noiseq.x;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  s_noiseq.x = x;
+  return (q31_t)x;
+}
+
+  /**
+   * Pink noise sample, -3dB per octave
+   *
+   * @return  Q31 with about .2 RMS
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t noise_pinkq() {
+  const q31_t w = noise_whiteq();
+//coefficients are scaled by 1/8 to keep the sum in range
+  s_noiseq.pink[0] = q31mul(s_noiseq.pink[0], 0x7FB2FEC5) + q31mul(w, 0x0195B142); // .99765, .0990460/8
+  s_noiseq.pink[1] = q31mul(s_noiseq.pink[1], 0x7B439581) + q31mul(w, 0x04BE87FB); // .96300, .2965164/8
+  s_noiseq.pink[2] = q31mul(s_noiseq.pink[2], 0x48F5C28F) + q31mul(w, 0x10D7D2D5); // .57000, 1.0526913/8
+  return q31add(q31add(s_noiseq.pink[0], s_noiseq.pink[1]), q31add(s_noiseq.pink[2], q31mul(w, 0x02F4F0D8))); // .1848/8
+}
+
+  /**
+   * Brown noise sample, -6dB per octave above about 120Hz
+   *
+   * @return  Q31 with about .2 RMS
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t noise_brownq() {
+  s_noiseq.brown = q31add(s_noiseq.brown - (s_noiseq.brown >> 6), noise_whiteq() >> 4);
+  return s_noiseq.brown;
+}
+
+  /**
+   * Fill a block with white noise
+   *
+   * @param out     Output buffer.
+   * @param frames  Number of samples.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void noise_white_fillq(q31_t * __restrict out, uint32_t frames) {
+  uint32_t x = s_noiseq.x;
+  for (uint32_t f = 0; f < frames; f++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    out[f] = (q31_t)x;
+  }
+  s_noiseq.x = x;
+}
+
+  /**
+   * Fill a block with pink noise
+   *
+   * @param out     Output buffer.
+   * @param frames  Number of samples.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void noise_pink_fillq(q31_t * __restrict out, uint32_t frames) {
+  for (uint32_t f = 0; f < frames; f++)
+    out[f] = noise_pinkq();
+}
+
+  /**
+   * Fill a block with brown noise
+   *
+   * @param out     Output buffer.
+   * @param frames  Number of samples.
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void noise_brown_fillq(q31_t * __restrict out, uint32_t frames) {
+  for (uint32_t f = 0; f < frames; f++)
+    out[f] = noise_brownq();
+}
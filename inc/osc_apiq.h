@@ -25,6 +25,7 @@
 #ifdef OSC_NOTE_Q
 #define k_samplerate_recipq M_1OVER48K_Q31
 #define k_note_max_hzq 0x3F254D91 //k_note_max_hz/48000
+#define k_note_mod_fscaleq 0x00808080 //1/255
 
 q31_t midi_to_hz_lut_q[k_midi_to_hz_size];
 
@@ -49,6 +50,17 @@ static inline __attribute__((optimize("Ofast"), always_inline))
 q31_t osc_w0q_for_note(uint8_t note, q31_t mod) {
   return clipmaxq(linintq(mod, osc_notehzq(note), osc_notehzq(note + 1)), k_note_max_hzq);
 }
+
+  /**
+   * Get Q31 phase increment for given note with fine modulation
+   *
+   * @param pitch Note in [0-151] range in the high byte, mod in [0-255] range in the low byte, the same as user_osc_param_t pitch.
+   * @return      Corresponding [0.0-1.0) phase increment in Q31, the fixed point counterpart of osc_w0f_for_note().
+   */
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t osc_w0q_for_pitch(uint16_t pitch) {
+  return osc_w0q_for_note(pitch >> 8, (pitch & 0xFF) * k_note_mod_fscaleq);
+}
 #endif
 
   /**
@@ -0,0 +1,145 @@
+/*
+ * File: perf.h
+ *
+ * Hot path instrumentation.
+ *
+ * Scoped section cycle counters accumulated per OSC_CYCLE block into
+ * a fixed size ring buffer of block stats. Cycles are counted with
+ * DWT CYCCNT on the target and in nanoseconds on the host.
+ * The host loader exposes the ring buffer as osc_host_t::perf.
+ *
+ * Optional definitions:
+ * - PERF_ENABLE: compile the instrumentation in, all the macros are empty otherwise
+ * - PERF_RING_SIZE: number of last blocks kept, 256 by default
+ *
+ * Usage:
+ *   PERF_INIT("section 0", "section 1", ...) at OSC_INIT
+ *   PERF_BLOCK_BEGIN() and PERF_BLOCK_END(frames) around OSC_CYCLE body
+ *   PERF_SCOPE(section) at the beginning of a section scope
+ *   PERF_SECTION(section) to end the previous sequential section and start the next one,
+ *   the last one is ended by PERF_BLOCK_END(frames)
+ *
+ * 2020 (c) Oleg Burdaev
+ * mailto: dukesrg@gmail.com
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef PERF_RING_SIZE
+#define PERF_RING_SIZE 256
+#endif
+#define PERF_SECTION_COUNT 4
+
+typedef struct {
+  uint32_t total;
+  uint32_t section[PERF_SECTION_COUNT];
+  uint32_t frames;
+} perf_block_t;
+
+typedef struct perf_ring_t {
+  uint32_t count; //blocks recorded, the last one is at (count - 1) % PERF_RING_SIZE
+  uint32_t section_count;
+  const char *name[PERF_SECTION_COUNT];
+  perf_block_t block[PERF_RING_SIZE];
+} perf_ring_t;
+
+#ifdef PERF_ENABLE
+
+#ifdef __arm__
+#define PERF_DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define PERF_DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define PERF_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#else
+#include <time.h>
+#endif
+
+#ifdef __arm__
+perf_ring_t perf_ring;
+#else
+extern "C" {
+__attribute__((visibility("default"))) perf_ring_t perf_ring; //resolved by the host loader
+}
+#endif
+static perf_block_t s_perf_block;
+static uint32_t s_perf_start;
+static uint32_t s_perf_lap;
+static uint32_t s_perf_section = PERF_SECTION_COUNT; //sequential section, none
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+uint32_t perf_cycles() {
+#ifdef __arm__
+  return PERF_DWT_CYCCNT;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static inline __attribute__((always_inline))
+void perf_init(uint32_t count, const char * const *name) {
+  perf_ring.count = 0;
+  perf_ring.section_count = count < PERF_SECTION_COUNT ? count : PERF_SECTION_COUNT;
+  for (uint32_t i = perf_ring.section_count; i--;)
+    perf_ring.name[i] = name[i];
+#ifdef __arm__
+  PERF_DEMCR |= 0x01000000; //TRCENA
+  PERF_DWT_CTRL |= 0x00000001; //CYCCNTENA
+#endif
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void perf_block_begin() {
+  for (uint32_t i = PERF_SECTION_COUNT; i--;)
+    s_perf_block.section[i] = 0;
+  s_perf_section = PERF_SECTION_COUNT;
+  s_perf_start = perf_cycles();
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void perf_section(uint32_t section) {
+  const uint32_t t = perf_cycles();
+  if (s_perf_section < PERF_SECTION_COUNT)
+    s_perf_block.section[s_perf_section] += t - s_perf_lap;
+  s_perf_section = section;
+  s_perf_lap = t;
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void perf_block_end(uint32_t frames) {
+  perf_section(PERF_SECTION_COUNT);
+  s_perf_block.total = perf_cycles() - s_perf_start;
+  s_perf_block.frames = frames;
+  perf_ring.block[perf_ring.count++ % PERF_RING_SIZE] = s_perf_block;
+}
+
+struct perf_scope_t {
+  const uint32_t section;
+  const uint32_t start;
+  __attribute__((always_inline)) perf_scope_t(uint32_t section) : section(section), start(perf_cycles()) {}
+  __attribute__((always_inline)) ~perf_scope_t() { s_perf_block.section[section] += perf_cycles() - start; }
+};
+
+#define PERF_INIT(...) do { \
+  static const char * const perf_names[] = {__VA_ARGS__}; \
+  perf_init(sizeof(perf_names) / sizeof(perf_names[0]), perf_names); \
+} while (0)
+#define PERF_BLOCK_BEGIN() perf_block_begin()
+#define PERF_BLOCK_END(frames) perf_block_end(frames)
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+#define PERF_SCOPE(section) perf_scope_t PERF_CONCAT(perf_scope_, __LINE__)(section)
+#define PERF_SECTION(section) perf_section(section)
+
+#else
+
+#define PERF_INIT(...)
+#define PERF_BLOCK_BEGIN()
+#define PERF_BLOCK_END(frames)
+#define PERF_SCOPE(section)
+#define PERF_SECTION(section)
+
+#endif
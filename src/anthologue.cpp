@@ -11,40 +11,110 @@
 #include "userosc.h"
 #include "fixed_mathq.h"
 #include "fx_api.h"
+#define OSC_NOTE_Q
 #include "osc_apiq.h"
+#include "noiseq.h"
+#include "governor.h"
+#include "perf.h"
 
 //#define BANK_SIZE 25
 #include "anthologue.h"
 
 #define VCO_COUNT 6
+#define VOICE_COUNT 4 //poly step voices at most
+#define VCO_BUDGET_NTS1 (VCO_COUNT * 2) //VCOs rendered at most by all the step voices
+#define VCO_BUDGET VCO_COUNT
+#define VCO_BLOCK 32 //frames rendered per VCO pass
+#define VCO_EDGE_COUNT 6 //discontinuities per cycle corrected in band-limited mode
+#define VCO_EDGE_MIN 0x00100000 //half step height below which a point is taken as continuous
+#define PROG_CACHE_SIZE 4 //decoded program records kept for quick program switching
+#define GOVERNOR_LEVELS (VCO_COUNT + VOICE_COUNT - 2) //band-limited VCOs fall back to naive first, then each level drops the last step voice and then the last active VCO, down to the first one
+#define SEQ_GATE_FULL 72 //gate time units per step
+
+enum {
+  perf_seq,
+  perf_vco,
+};
 
 static q31_t s_params[p_num];
+
+//hot VCO parameters mirrored from s_params by setParam()
+typedef struct {
+  int32_t pitch[VCO_COUNT]; //pitch with octave, 1/256 semitone
+  q31_t level[VCO_COUNT];
+  q31_t shape[VCO_COUNT];
+  q31_t cross[VCO_COUNT];
+  uint8_t wave[VCO_COUNT]; //wave_num for silence
+  uint8_t chain[VCO_COUNT]; //ring << 2 | sync << 1 | cross
+} vco_params_t;
+
+static vco_params_t s_vco;
 static uint32_t s_platform;
 
-static uint8_t s_seq_len;
-static uint32_t s_seq_res;
+//sequencer event, voices are step note bits
+typedef struct {
+  uint8_t step;
+  uint8_t type;
+  uint8_t gate; //gate off time in SEQ_GATE_FULL units of the step
+  uint8_t voices;
+} seq_event_t;
+
+enum {
+  seq_event_step,
+  seq_event_gate_off,
+};
+
+//decoded sequence of a program
+typedef struct {
+  uint8_t len;
+  uint8_t event_count;
+  uint16_t step_mask;
+  uint32_t res;
+  uint32_t rcp; //2^48 / res, rounded up
+  uint8_t note[SEQ_STEP_COUNT][SEQ_POLY];
+  uint8_t vel[SEQ_STEP_COUNT][SEQ_POLY];
+  uint8_t gate[SEQ_STEP_COUNT][SEQ_POLY];
+  uint8_t motion_param[SEQ_MOTION_SLOT_COUNT];
+  uint8_t motion_start[SEQ_STEP_COUNT][SEQ_MOTION_SLOT_COUNT];
+  int16_t motion_diff[SEQ_STEP_COUNT][SEQ_MOTION_SLOT_COUNT];
+  seq_event_t event[SEQ_STEP_COUNT * (SEQ_POLY + 1)]; //in time order
+} seq_rec_t;
+
+//decoded program, VCO params are in the main timbre layout
+typedef struct {
+  uint32_t index;
+  uint8_t type;
+  q31_t params[p_num];
+  seq_rec_t seq;
+} prog_rec_t;
+
+static prog_rec_t s_progcache[PROG_CACHE_SIZE];
+static uint32_t s_progcache_used[PROG_CACHE_SIZE]; //LRU stamps, 0 = empty
+static uint32_t s_progcache_stamp;
+static const seq_rec_t s_seq_none = {};
+static const seq_rec_t *s_seq = &s_seq_none; //sequence of the main timbre program
+
 static uint8_t s_seq_step;
-static uint16_t s_seq_step_bit;
-static uint16_t s_seq_step_mask;
-static uint32_t s_sample_pos;
-static uint8_t s_seq_note[SEQ_STEP_COUNT];
-static uint8_t s_seq_vel[SEQ_STEP_COUNT];
-static q31_t s_seq_gate[SEQ_STEP_COUNT];
-static uint32_t s_seq_gate_len;
-static bool s_seq_gate_on;
-static uint32_t s_seq_quant;
+static uint8_t s_seq_event; //next event index
+static uint32_t s_seq_event_pos; //next event step phase
+static uint32_t s_seq_phase; //step phase, 0x80000000 is the step end
+static uint32_t s_seq_w0; //step phase increment per sample
+static uint32_t s_seq_k; //0xFFFFFFFF / s_seq_w0, frames to an event by multiply
+static uint32_t s_seq_bpm; //the clock is set for
+static uint32_t s_seq_rcp;
+static uint32_t s_seq_voices; //voices of the step notes
+static uint32_t s_seq_gate; //voices with the gate on
+static uint8_t s_seq_slot[VOICE_COUNT]; //step note of a voice
 
 static bool s_seq_started;
 static uint32_t s_note_pitch;
-static uint32_t s_seq_step_pitch;
+static int32_t s_seq_pitch[VOICE_COUNT];
 static int16_t s_seq_transpose;
-static uint8_t s_seq_motion_start[SEQ_STEP_COUNT][SEQ_MOTION_SLOT_COUNT];
-static uint8_t s_seq_motion_diff[SEQ_STEP_COUNT][SEQ_MOTION_SLOT_COUNT];
-static uint8_t s_seq_motion_param[SEQ_MOTION_SLOT_COUNT];
-static q31_t s_seq_motion_delta[SEQ_MOTION_SLOT_COUNT];
-static q31_t s_seq_motion_value[SEQ_MOTION_SLOT_COUNT];
+static q31_t s_seq_motion_start[SEQ_MOTION_SLOT_COUNT];
+static q31_t s_seq_motion_diff[SEQ_MOTION_SLOT_COUNT];
 
-static q31_t s_phase[VCO_COUNT];
+static q31_t s_phase[VOICE_COUNT][VCO_COUNT];
+static q31_t s_blep[VOICE_COUNT][VCO_COUNT]; //sync reset residual for the next sample
 //static bool s_tie;
 
 static q31_t s_main_balance;
@@ -53,327 +123,394 @@ static uint8_t s_prog = -1;
 static uint8_t s_sub = -1;
 static uint8_t s_prog_type;
 static uint8_t s_play_mode = mode_note;
+static uint8_t s_quality = quality_naive;
+static uint8_t s_vco_quality = quality_naive; //last rendered, the sync residuals belong to it
 static uint8_t s_assignable[2] = {p_slider_assign, p_pedal_assign};
+static uint32_t s_vco_budget = VCO_BUDGET;
 
-//static inline __attribute__((optimize("Ofast"), always_inline))
-void initVoice(uint32_t timbre) {
-  const void *prog_ptr = getProg(timbre == timbre_main ? s_prog : s_sub, &s_prog_type);
+static void initSeqEvents(seq_rec_t *seq) {
+  seq_event_t *ev = seq->event;
+  for (uint32_t i = 0; i < seq->len && i < SEQ_STEP_COUNT; i++) {
+    uint32_t voices = 0;
+    if ((seq->step_mask >> i) & 1)
+      for (uint32_t n = 0; n < SEQ_POLY; n++)
+        if (seq->vel[i][n])
+          voices |= 1 << n;
+    ev->step = i;
+    ev->type = seq_event_step;
+    ev->gate = 0;
+    ev++->voices = voices;
+//gate offs of the step in time order, notes with the same gate time share one
+    while (voices) {
+      uint32_t gate = SEQ_GATE_FULL, off = 0;
+      for (uint32_t n = 0; n < SEQ_POLY; n++) {
+        if (!((voices >> n) & 1))
+          continue;
+        if (seq->gate[i][n] < gate) {
+          gate = seq->gate[i][n];
+          off = 1 << n;
+        } else if (seq->gate[i][n] == gate) {
+          off |= 1 << n;
+        }
+      }
+      if (gate == SEQ_GATE_FULL)
+        break;
+      ev->step = i;
+      ev->type = seq_event_gate_off;
+      ev->gate = gate;
+      ev++->voices = off;
+      voices &= ~off;
+    }
+  }
+  seq->event_count = ev - seq->event;
+//no steps to carry the motion values
+  if (seq->event_count == 0)
+    for (uint32_t j = 0; j < SEQ_MOTION_SLOT_COUNT; j++)
+      seq->motion_param[j] = 0;
+  seq->rcp = seq->res ? (uint32_t)((0xFFFFFFFFFFFFULL + seq->res) / seq->res) : 0;
+}
 
-  for (uint32_t i = timbre == timbre_main ? p_vco1_wave : p_vco4_wave; i <= p_vco6_cross; i++)
-    s_params[i] = 0;
+static void decodeProg(prog_rec_t *rec, uint32_t index) {
+  const void *prog_ptr = getProg(index, &rec->type);
+  seq_rec_t *seq = &rec->seq;
 
-  if (timbre == timbre_main) {
-    s_params[p_sub_on] = 0;
-    s_params[p_timbre_type] = timbre_layer;
-    s_params[p_main_sub_position] = 0;
-    s_params[p_split_point] = 60;
-    s_params[p_main_sub_balance] = 0x40000000;
-  }
+  rec->index = index;
+  for (uint32_t i = 0; i < p_num; i++)
+    rec->params[i] = 0;
+  rec->params[p_timbre_type] = timbre_layer;
+  rec->params[p_split_point] = 60;
+  rec->params[p_main_sub_balance] = 0x40000000;
+  *seq = s_seq_none;
 
-  switch (s_prog_type) {
+  switch (rec->type) {
     case minilogue_ID: {
       const mnlg_prog_t *p = (mnlg_prog_t*)prog_ptr;
  
-      s_params[p_vco1_pitch + timbre] = getPitch(to10bit(p->vco1_pitch_hi, p->vco1_pitch_lo));
-      s_params[p_vco2_pitch + timbre] = getPitch(to10bit(p->vco2_pitch_hi, p->vco2_pitch_lo));
-      s_params[p_vco1_shape + timbre] = param_val_to_q31(to10bit(p->vco1_shape_hi, p->vco1_shape_lo));
-      s_params[p_vco2_shape + timbre] = param_val_to_q31(to10bit(p->vco2_shape_hi, p->vco2_shape_lo));
-      s_params[p_vco1_octave + timbre] = (p->vco1_octave - 1) * 12;
-      s_params[p_vco2_octave + timbre] = (p->vco2_octave - 1) * 12;
-      s_params[p_vco1_wave + timbre] = p->vco1_wave;
-      s_params[p_vco2_wave + timbre] = p->vco2_wave;
-      s_params[p_vco3_wave + timbre] = wave_noise;
-      s_params[p_vco1_level + timbre] = param_val_to_q31(to10bit(p->vco1_level_hi, p->vco1_level_lo));
-      s_params[p_vco2_level + timbre] = param_val_to_q31(to10bit(p->vco2_level_hi, p->vco2_level_lo));
-      s_params[p_vco3_level + timbre] = param_val_to_q31(to10bit(p->noise_level_hi, p->noise_level_lo));
-      s_params[p_vco2_sync + timbre] = ~p->sync;
-      s_params[p_vco2_ring + timbre] = ~p->ring;
-      s_params[p_vco2_cross + timbre] = param_val_to_q31(to10bit(p->cross_mod_depth_hi, p->cross_mod_depth_lo));
+      rec->params[p_vco1_pitch] = getPitch(to10bit(p->vco1_pitch_hi, p->vco1_pitch_lo));
+      rec->params[p_vco2_pitch] = getPitch(to10bit(p->vco2_pitch_hi, p->vco2_pitch_lo));
+      rec->params[p_vco1_shape] = param_val_to_q31(to10bit(p->vco1_shape_hi, p->vco1_shape_lo));
+      rec->params[p_vco2_shape] = param_val_to_q31(to10bit(p->vco2_shape_hi, p->vco2_shape_lo));
+      rec->params[p_vco1_octave] = (p->vco1_octave - 1) * 12;
+      rec->params[p_vco2_octave] = (p->vco2_octave - 1) * 12;
+      rec->params[p_vco1_wave] = p->vco1_wave;
+      rec->params[p_vco2_wave] = p->vco2_wave;
+      rec->params[p_vco3_wave] = wave_noise;
+      rec->params[p_vco1_level] = param_val_to_q31(to10bit(p->vco1_level_hi, p->vco1_level_lo));
+      rec->params[p_vco2_level] = param_val_to_q31(to10bit(p->vco2_level_hi, p->vco2_level_lo));
+      rec->params[p_vco3_level] = param_val_to_q31(to10bit(p->noise_level_hi, p->noise_level_lo));
+      rec->params[p_vco2_sync] = ~p->sync;
+      rec->params[p_vco2_ring] = ~p->ring;
+      rec->params[p_vco2_cross] = param_val_to_q31(to10bit(p->cross_mod_depth_hi, p->cross_mod_depth_lo));
 //todo: drive
-//      s_params[p_drive] = 0;
-      if (timbre == timbre_main) {
-//      s_params[p_pitch_bend] = 0;
-      s_params[p_bend_range_pos] = p->bend_range_pos;
-      s_params[p_bend_range_neg] = p->bend_range_neg;
-      s_params[p_slider_assign] = p->slider_assign;
-      s_params[p_pedal_assign] = p->slider_assign;
+//      rec->params[p_drive] = 0;
+//      rec->params[p_pitch_bend] = 0;
+      rec->params[p_bend_range_pos] = p->bend_range_pos;
+      rec->params[p_bend_range_neg] = p->bend_range_neg;
+      rec->params[p_slider_assign] = p->slider_assign;
+      rec->params[p_pedal_assign] = p->slider_assign;
 //todo: slider range
-//      s_params[p_slider_range] = 0x7FFFFFFF;
-//      s_params[p_pedal_range] = 0x7FFFFFFF;
+//      rec->params[p_slider_range] = 0x7FFFFFFF;
+//      rec->params[p_pedal_range] = 0x7FFFFFFF;
 
-      s_params[p_program_level] = (p->program_level - 102) * 0x0147AE14;
-      s_params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
-      s_params[p_bpm] = p->bpm;
+      rec->params[p_program_level] = (p->program_level - 102) * 0x0147AE14;
+      rec->params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
+      rec->params[p_bpm] = p->bpm;
 
-      s_seq_len = p->step_length;
-      s_seq_res = (k_samplerate * 150) << p->step_resolution;
-      s_seq_step_mask = p->step_mask;
+      seq->len = p->step_length;
+      seq->res = (k_samplerate * 150) << p->step_resolution;
+      seq->step_mask = p->step_mask;
       for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
-        s_seq_note[i] = p->step_event_data[i].note[0];
-        s_seq_vel[i] = p->step_event_data[i].velocity[0];
-        if (p->step_event_data[i].gate[0].gate_time < 72)
-          s_seq_gate[i] = (uint32_t)(p->step_event_data[i].gate[0].gate_time) * 0x01C71C72;
-        else if (p->step_event_data[i].gate[0].gate_time == 72)
-          s_seq_gate[i] = 0x7FFFFFFF;
-//todo: tie
-//        else
-//
+        for (uint32_t n = 0; n < MNLG_POLY; n++) {
+          seq->note[i][n] = p->step_event_data[i].note[n];
+          seq->vel[i][n] = p->step_event_data[i].velocity[n];
+//tie is held for the full step, todo: legato into the next step
+          seq->gate[i][n] = p->step_event_data[i].gate[n].gate_time < SEQ_GATE_FULL ? p->step_event_data[i].gate[n].gate_time : SEQ_GATE_FULL;
+        }
         for (uint32_t j = 0; j < SEQ_MOTION_SLOT_COUNT; j++) {
           const motion_slot_param_t *motion_slot_param = &(p->motion_slot_param[j]);
           if ((p->motion_slot_step_mask[j] & (1 << i)) && motion_slot_param->motion_enable) {
             if (motion_slot_param->parameter_id >= MOTION_PARAM_LUT_FIRST && motion_slot_param->parameter_id <= MOTION_PARAM_LUT_LAST)
-             s_seq_motion_param[j] = motion_param_lut[s_prog_type][motion_slot_param->parameter_id - MOTION_PARAM_LUT_FIRST];
+             seq->motion_param[j] = motion_param_lut[rec->type][motion_slot_param->parameter_id - MOTION_PARAM_LUT_FIRST];
              else if (motion_slot_param->parameter_id == 61)
-              s_seq_motion_param[j] = p_pitch_bend;
+              seq->motion_param[j] = p_pitch_bend;
             else
-              s_seq_motion_param[j] = 0;
-            if (s_seq_motion_param[j]) {
-              s_seq_motion_start[i][j] = p->step_event_data[i].motion_slot_data[j][0];
+              seq->motion_param[j] = 0;
+            if (seq->motion_param[j]) {
+              seq->motion_start[i][j] = p->step_event_data[i].motion_slot_data[j][0];
               if (motion_slot_param->smooth_enable)
-                s_seq_motion_diff[i][j] = p->step_event_data[i].motion_slot_data[j][1] - s_seq_motion_start[i][j];
+                seq->motion_diff[i][j] = p->step_event_data[i].motion_slot_data[j][1] - seq->motion_start[i][j];
               else
-                s_seq_motion_diff[i][j] = 0;
+                seq->motion_diff[i][j] = 0;
             }
           } else
-            s_seq_motion_param[j] = 0;
+            seq->motion_param[j] = 0;
         }
       }
-      }
     }; break;
     case monologue_ID: {
       const molg_prog_t *p = (molg_prog_t*)prog_ptr;
  
-      s_params[p_vco1_pitch + timbre] = getPitch(to10bit(p->vco1_pitch_hi, p->vco1_pitch_lo));
-      s_params[p_vco2_pitch + timbre] = getPitch(to10bit(p->vco2_pitch_hi, p->vco2_pitch_lo));
-      s_params[p_vco1_shape + timbre] = param_val_to_q31(to10bit(p->vco1_shape_hi, p->vco1_shape_lo));
-      s_params[p_vco2_shape + timbre] = param_val_to_q31(to10bit(p->vco2_shape_hi, p->vco2_shape_lo));
-      s_params[p_vco1_octave + timbre] = (p->vco1_octave - 1) * 12;
-      s_params[p_vco2_octave + timbre] = (p->vco2_octave - 1) * 12;
-      s_params[p_vco1_wave + timbre] = p->vco1_wave;
-      s_params[p_vco2_wave + timbre] = p->vco2_wave == wave_sqr ? (uint32_t)wave_noise : p->vco2_wave;
-      s_params[p_vco3_wave + timbre] = wave_noise;
-      s_params[p_vco1_level + timbre] = param_val_to_q31(to10bit(p->vco1_level_hi, p->vco1_level_lo));
-      s_params[p_vco2_level + timbre] = param_val_to_q31(to10bit(p->vco2_level_hi, p->vco2_level_lo));
-      s_params[p_vco2_sync + timbre] = p->ring_sync==2;
-      s_params[p_vco2_ring + timbre] = p->ring_sync==0;
+      rec->params[p_vco1_pitch] = getPitch(to10bit(p->vco1_pitch_hi, p->vco1_pitch_lo));
+      rec->params[p_vco2_pitch] = getPitch(to10bit(p->vco2_pitch_hi, p->vco2_pitch_lo));
+      rec->params[p_vco1_shape] = param_val_to_q31(to10bit(p->vco1_shape_hi, p->vco1_shape_lo));
+      rec->params[p_vco2_shape] = param_val_to_q31(to10bit(p->vco2_shape_hi, p->vco2_shape_lo));
+      rec->params[p_vco1_octave] = (p->vco1_octave - 1) * 12;
+      rec->params[p_vco2_octave] = (p->vco2_octave - 1) * 12;
+      rec->params[p_vco1_wave] = p->vco1_wave;
+      rec->params[p_vco2_wave] = p->vco2_wave == wave_sqr ? (uint32_t)wave_noise : p->vco2_wave;
+      rec->params[p_vco3_wave] = wave_noise;
+      rec->params[p_vco1_level] = param_val_to_q31(to10bit(p->vco1_level_hi, p->vco1_level_lo));
+      rec->params[p_vco2_level] = param_val_to_q31(to10bit(p->vco2_level_hi, p->vco2_level_lo));
+      rec->params[p_vco2_sync] = p->ring_sync==2;
+      rec->params[p_vco2_ring] = p->ring_sync==0;
 //todo: drive
-//      s_params[p_drive] = param_val_to_q31(to10bit(p->drive_hi, p->drive_lo));
-      if (timbre == timbre_main) {
-//      s_params[p_pitch_bend] = 0;
-      s_params[p_bend_range_pos] = p->bend_range_pos;
-      s_params[p_bend_range_neg] = p->bend_range_neg;
-      s_params[p_slider_assign] = p->slider_assign;
-      s_params[p_pedal_assign] = p->slider_assign;
+//      rec->params[p_drive] = param_val_to_q31(to10bit(p->drive_hi, p->drive_lo));
+//      rec->params[p_pitch_bend] = 0;
+      rec->params[p_bend_range_pos] = p->bend_range_pos;
+      rec->params[p_bend_range_neg] = p->bend_range_neg;
+      rec->params[p_slider_assign] = p->slider_assign;
+      rec->params[p_pedal_assign] = p->slider_assign;
 //todo: slider range
-//      s_params[p_slider_range] = 0x7FFFFFFF;
-//      s_params[p_pedal_range] = 0x7FFFFFFF;
+//      rec->params[p_slider_range] = 0x7FFFFFFF;
+//      rec->params[p_pedal_range] = 0x7FFFFFFF;
 
-      s_params[p_program_level] = (p->program_level - 102) * 0x0147AE14;
-      s_params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
-      s_params[p_bpm] = p->bpm;
+      rec->params[p_program_level] = (p->program_level - 102) * 0x0147AE14;
+      rec->params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
+      rec->params[p_bpm] = p->bpm;
 
-      s_seq_len = p->step_length;
-      s_seq_res = (k_samplerate * 150) << p->step_resolution;
-      s_seq_step_mask = p->step_mask;
+      seq->len = p->step_length;
+      seq->res = (k_samplerate * 150) << p->step_resolution;
+      seq->step_mask = p->step_mask;
       for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
-        s_seq_note[i] = p->step_event_data[i].note;
-        s_seq_vel[i] = p->step_event_data[i].velocity;
-        if (p->step_event_data[i].gate.gate_time < 72)
-          s_seq_gate[i] = (uint32_t)(p->step_event_data[i].gate.gate_time) * 0x01C71C72;
-        else if (p->step_event_data[i].gate.gate_time == 72)
-          s_seq_gate[i] = 0x7FFFFFFF;
-//todo: tie
-//        else
-//
+        seq->note[i][0] = p->step_event_data[i].note;
+        seq->vel[i][0] = p->step_event_data[i].velocity;
+//tie is held for the full step, todo: legato into the next step
+        seq->gate[i][0] = p->step_event_data[i].gate.gate_time < SEQ_GATE_FULL ? p->step_event_data[i].gate.gate_time : SEQ_GATE_FULL;
         for (uint32_t j = 0; j < SEQ_MOTION_SLOT_COUNT; j++) {
           const motion_slot_param_t *motion_slot_param = &(p->motion_slot_param[j]);
           if ((p->motion_slot_step_mask[j] & (1 << i)) && motion_slot_param->motion_enable) {
             if (motion_slot_param->parameter_id >= MOTION_PARAM_LUT_FIRST && motion_slot_param->parameter_id <= MOTION_PARAM_LUT_LAST)
-              s_seq_motion_param[j] = motion_param_lut[s_prog_type][motion_slot_param->parameter_id - MOTION_PARAM_LUT_FIRST];
+              seq->motion_param[j] = motion_param_lut[rec->type][motion_slot_param->parameter_id - MOTION_PARAM_LUT_FIRST];
             else if (motion_slot_param->parameter_id == 56)
-              s_seq_motion_param[j] = p_pitch_bend;
+              seq->motion_param[j] = p_pitch_bend;
             else
-              s_seq_motion_param[j] = 0;
-            if (s_seq_motion_param[j]) {
-              s_seq_motion_start[i][j] = p->step_event_data[i].motion_slot_data[j][0];
+              seq->motion_param[j] = 0;
+            if (seq->motion_param[j]) {
+              seq->motion_start[i][j] = p->step_event_data[i].motion_slot_data[j][0];
               if (motion_slot_param->smooth_enable)
-                s_seq_motion_diff[i][j] = p->step_event_data[i].motion_slot_data[j][1] - s_seq_motion_start[i][j];
+                seq->motion_diff[i][j] = p->step_event_data[i].motion_slot_data[j][1] - seq->motion_start[i][j];
               else
-                s_seq_motion_diff[i][j] = 0;
+                seq->motion_diff[i][j] = 0;
             }
           } else
-            s_seq_motion_param[j] = 0;
+            seq->motion_param[j] = 0;
         }
       }
-      }
     }; break;
     case prologue_ID: {
       const prlg_prog_t *p = (prlg_prog_t*)prog_ptr;
       const prlg_timbre_t *t = &p->timbre[0];
 
-      s_params[p_vco1_pitch + timbre] = getPitch(t->vco1_pitch);
-      s_params[p_vco2_pitch + timbre] = getPitch(prlgto10bit(t->vco2_pitch_hi, t->vco2_pitch_lo));
-      s_params[p_vco1_shape + timbre] = param_val_to_q31(t->vco1_shape);
-      s_params[p_vco2_shape + timbre] = param_val_to_q31(prlgto10bit(t->vco2_shape_hi, t->vco2_shape_lo));
-      s_params[p_vco3_shape + timbre] = param_val_to_q31(t->multi_type==multi_noise ? t->noise_shape : 0);
-      s_params[p_vco1_octave + timbre] = (t->vco1_octave - 1) * 12;
-      s_params[p_vco2_octave + timbre] = (t->vco2_octave - 1) * 12;
-      s_params[p_vco3_octave + timbre] = (t->multi_octave - 1) * 12;
-      s_params[p_vco1_wave + timbre] = t->vco1_wave;
-      s_params[p_vco2_wave + timbre] = t->vco2_wave;
-      s_params[p_vco3_wave + timbre] = t->multi_type==multi_noise ? wave_noise : wave_sqr;
-      s_params[p_vco1_level + timbre] = param_val_to_q31(t->vco1_level);
-      s_params[p_vco2_level + timbre] = param_val_to_q31(t->vco2_level);
-      s_params[p_vco3_level + timbre] = param_val_to_q31(t->multi_type==multi_noise ? t->multi_level : 0);
-      s_params[p_vco2_sync + timbre] = t->ring_sync==2;
-      s_params[p_vco2_ring + timbre] = t->ring_sync==0;
-      s_params[p_vco2_cross + timbre] = param_val_to_q31(t->cross_mod_depth);
+      rec->params[p_vco1_pitch] = getPitch(t->vco1_pitch);
+      rec->params[p_vco2_pitch] = getPitch(prlgto10bit(t->vco2_pitch_hi, t->vco2_pitch_lo));
+      rec->params[p_vco1_shape] = param_val_to_q31(t->vco1_shape);
+      rec->params[p_vco2_shape] = param_val_to_q31(prlgto10bit(t->vco2_shape_hi, t->vco2_shape_lo));
+      rec->params[p_vco3_shape] = param_val_to_q31(t->multi_type==multi_noise ? t->noise_shape : 0);
+      rec->params[p_vco1_octave] = (t->vco1_octave - 1) * 12;
+      rec->params[p_vco2_octave] = (t->vco2_octave - 1) * 12;
+      rec->params[p_vco3_octave] = (t->multi_octave - 1) * 12;
+      rec->params[p_vco1_wave] = t->vco1_wave;
+      rec->params[p_vco2_wave] = t->vco2_wave;
+      rec->params[p_vco3_wave] = t->multi_type==multi_noise ? wave_noise : wave_sqr;
+      rec->params[p_vco1_level] = param_val_to_q31(t->vco1_level);
+      rec->params[p_vco2_level] = param_val_to_q31(t->vco2_level);
+      rec->params[p_vco3_level] = param_val_to_q31(t->multi_type==multi_noise ? t->multi_level : 0);
+      rec->params[p_vco2_sync] = t->ring_sync==2;
+      rec->params[p_vco2_ring] = t->ring_sync==0;
+      rec->params[p_vco2_cross] = param_val_to_q31(t->cross_mod_depth);
 //todo: drive
-//      s_params[p_drive] = 0;
-      if (timbre == timbre_main) {
-//      s_params[p_pitch_bend] = 0;
-      s_params[p_bend_range_pos] = t->bend_range_pos;
-      s_params[p_bend_range_neg] = t->bend_range_neg;
-      s_params[p_slider_assign] = t->mod_wheel_assign;
-      s_params[p_pedal_assign] = t->e_pedal_assign;
+//      rec->params[p_drive] = 0;
+//      rec->params[p_pitch_bend] = 0;
+      rec->params[p_bend_range_pos] = t->bend_range_pos;
+      rec->params[p_bend_range_neg] = t->bend_range_neg;
+      rec->params[p_slider_assign] = t->mod_wheel_assign;
+      rec->params[p_pedal_assign] = t->e_pedal_assign;
 //todo: mod wheel range
-//      s_params[p_slider_range] = (t->mod_wheel_range - 100) * 0x0147AE14;
-//      s_params[p_pedal_range] = 0x7FFFFFFF;
-      s_params[p_timbre_type] = p->timbre_type;
-      s_params[p_sub_on] = (s_platform == k_user_target_nutektdigital || s_params[p_timbre_type] == timbre_split) ? p->sub_on_pgm_fetch : 0;
-      s_params[p_main_sub_position] = p->main_sub_position;
-      s_params[p_split_point] = p->split_point;
-      s_params[p_main_sub_balance] = p->main_sub_balance * 0x01020408; // 1/127
+//      rec->params[p_slider_range] = (t->mod_wheel_range - 100) * 0x0147AE14;
+//      rec->params[p_pedal_range] = 0x7FFFFFFF;
+      rec->params[p_timbre_type] = p->timbre_type;
+      rec->params[p_sub_on] = (s_platform == k_user_target_nutektdigital || rec->params[p_timbre_type] == timbre_split) ? p->sub_on_pgm_fetch : 0;
+      rec->params[p_main_sub_position] = p->main_sub_position;
+      rec->params[p_split_point] = p->split_point;
+      rec->params[p_main_sub_balance] = p->main_sub_balance * 0x01020408; // 1/127
 
       t = &p->timbre[1];
-      timbre = timbre_sub;
-      s_params[p_vco1_pitch + timbre] = getPitch(t->vco1_pitch);
-      s_params[p_vco2_pitch + timbre] = getPitch(prlgto10bit(t->vco2_pitch_hi, t->vco2_pitch_lo));
-      s_params[p_vco1_shape + timbre] = param_val_to_q31(t->vco1_shape);
-      s_params[p_vco2_shape + timbre] = param_val_to_q31(prlgto10bit(t->vco2_shape_hi, t->vco2_shape_lo));
-      s_params[p_vco3_shape + timbre] = param_val_to_q31(t->multi_type==multi_noise ? t->noise_shape : 0);
-      s_params[p_vco1_octave + timbre] = (t->vco1_octave - 1) * 12;
-      s_params[p_vco2_octave + timbre] = (t->vco2_octave - 1) * 12;
-      s_params[p_vco3_octave + timbre] = (t->multi_octave - 1) * 12;
-      s_params[p_vco1_wave + timbre] = t->vco1_wave;
-      s_params[p_vco2_wave + timbre] = t->vco2_wave;
-      s_params[p_vco3_wave + timbre] = t->multi_type==multi_noise ? wave_noise : wave_sqr;
-      s_params[p_vco1_level + timbre] = param_val_to_q31(t->vco1_level);
-      s_params[p_vco2_level + timbre] = param_val_to_q31(t->vco2_level);
-      s_params[p_vco3_level + timbre] = param_val_to_q31(t->multi_type==multi_noise ? t->multi_level : 0);
-      s_params[p_vco2_sync + timbre] = t->ring_sync==2;
-      s_params[p_vco2_ring + timbre] = t->ring_sync==0;
-      s_params[p_vco2_cross + timbre] = param_val_to_q31(t->cross_mod_depth);
+      const uint32_t timbre = timbre_sub;
+      rec->params[p_vco1_pitch + timbre] = getPitch(t->vco1_pitch);
+      rec->params[p_vco2_pitch + timbre] = getPitch(prlgto10bit(t->vco2_pitch_hi, t->vco2_pitch_lo));
+      rec->params[p_vco1_shape + timbre] = param_val_to_q31(t->vco1_shape);
+      rec->params[p_vco2_shape + timbre] = param_val_to_q31(prlgto10bit(t->vco2_shape_hi, t->vco2_shape_lo));
+      rec->params[p_vco3_shape + timbre] = param_val_to_q31(t->multi_type==multi_noise ? t->noise_shape : 0);
+      rec->params[p_vco1_octave + timbre] = (t->vco1_octave - 1) * 12;
+      rec->params[p_vco2_octave + timbre] = (t->vco2_octave - 1) * 12;
+      rec->params[p_vco3_octave + timbre] = (t->multi_octave - 1) * 12;
+      rec->params[p_vco1_wave + timbre] = t->vco1_wave;
+      rec->params[p_vco2_wave + timbre] = t->vco2_wave;
+      rec->params[p_vco3_wave + timbre] = t->multi_type==multi_noise ? wave_noise : wave_sqr;
+      rec->params[p_vco1_level + timbre] = param_val_to_q31(t->vco1_level);
+      rec->params[p_vco2_level + timbre] = param_val_to_q31(t->vco2_level);
+      rec->params[p_vco3_level + timbre] = param_val_to_q31(t->multi_type==multi_noise ? t->multi_level : 0);
+      rec->params[p_vco2_sync + timbre] = t->ring_sync==2;
+      rec->params[p_vco2_ring + timbre] = t->ring_sync==0;
+      rec->params[p_vco2_cross + timbre] = param_val_to_q31(t->cross_mod_depth);
 
 //todo: true dB level conversion
-      s_params[p_program_level] = p->program_level - 100;
-      if (s_params[p_program_level] >= 32)
-        s_params[p_program_level] = 0x7FFFFFFF; // +6dB
-      if (s_params[p_program_level] > 0)
-        s_params[p_program_level] *= 0x04000000; // (+0...+6dB) 1/32
-      else if (s_params[p_program_level] < 0)
-        s_params[p_program_level] *= 0x0145D174; // (-0dB...-18dB] 7/8 / 88
-      s_params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
-      s_params[p_bpm] = p->bpm;
-
-      s_seq_len = 0;
-      s_seq_res = 0;
-      s_seq_step_mask = 0;
-      for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
-        s_seq_note[i] = 0;
-        s_seq_vel[i] = 0;
-        s_seq_gate[i] = 0;
-        for (uint32_t j = 0; j < SEQ_MOTION_SLOT_COUNT; j++) {
-          s_seq_motion_param[j] = 0;
-          s_seq_motion_start[i][j] = 0;
-          s_seq_motion_diff[i][j] = 0;
-        }
-      }
-      }
+      rec->params[p_program_level] = p->program_level - 100;
+      if (rec->params[p_program_level] >= 32)
+        rec->params[p_program_level] = 0x7FFFFFFF; // +6dB
+      if (rec->params[p_program_level] > 0)
+        rec->params[p_program_level] *= 0x04000000; // (+0...+6dB) 1/32
+      else if (rec->params[p_program_level] < 0)
+        rec->params[p_program_level] *= 0x0145D174; // (-0dB...-18dB] 7/8 / 88
+      rec->params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
+      rec->params[p_bpm] = p->bpm;
     }; break;
     case minilogue_xd_ID: {
       const mnlgxd_prog_t *p = (mnlgxd_prog_t*)prog_ptr;
 
-      s_params[p_vco1_pitch + timbre] = getPitch(p->vco1_pitch);
-      s_params[p_vco2_pitch + timbre] = getPitch(p->vco2_pitch);
-      s_params[p_vco1_shape + timbre] = param_val_to_q31(p->vco1_shape);
-      s_params[p_vco2_shape + timbre] = param_val_to_q31(p->vco2_shape);
-      s_params[p_vco3_shape + timbre] = param_val_to_q31(p->multi_type==multi_noise ? p->noise_shape : 0);
-      s_params[p_vco1_octave + timbre] = (p->vco1_octave - 1) * 12;
-      s_params[p_vco2_octave + timbre] = (p->vco2_octave - 1) * 12;
-      s_params[p_vco3_octave + timbre] = (p->multi_octave - 1) * 12;
-      s_params[p_vco1_wave + timbre] = p->vco1_wave;
-      s_params[p_vco2_wave + timbre] = p->vco2_wave;
-      s_params[p_vco3_wave + timbre] = p->multi_type==multi_noise ? wave_noise : wave_sqr;
-      s_params[p_vco1_level + timbre] = param_val_to_q31(p->vco1_level);
-      s_params[p_vco2_level + timbre] = param_val_to_q31(p->vco2_level);
-      s_params[p_vco3_level + timbre] = param_val_to_q31(p->multi_type==multi_noise ? p->multi_level : 0);
-      s_params[p_vco2_sync + timbre] = ~p->sync;
-      s_params[p_vco2_ring + timbre] = ~p->ring;
-      s_params[p_vco2_cross + timbre] = param_val_to_q31(p->cross_mod_depth);
+      rec->params[p_vco1_pitch] = getPitch(p->vco1_pitch);
+      rec->params[p_vco2_pitch] = getPitch(p->vco2_pitch);
+      rec->params[p_vco1_shape] = param_val_to_q31(p->vco1_shape);
+      rec->params[p_vco2_shape] = param_val_to_q31(p->vco2_shape);
+      rec->params[p_vco3_shape] = param_val_to_q31(p->multi_type==multi_noise ? p->noise_shape : 0);
+      rec->params[p_vco1_octave] = (p->vco1_octave - 1) * 12;
+      rec->params[p_vco2_octave] = (p->vco2_octave - 1) * 12;
+      rec->params[p_vco3_octave] = (p->multi_octave - 1) * 12;
+      rec->params[p_vco1_wave] = p->vco1_wave;
+      rec->params[p_vco2_wave] = p->vco2_wave;
+      rec->params[p_vco3_wave] = p->multi_type==multi_noise ? wave_noise : wave_sqr;
+      rec->params[p_vco1_level] = param_val_to_q31(p->vco1_level);
+      rec->params[p_vco2_level] = param_val_to_q31(p->vco2_level);
+      rec->params[p_vco3_level] = param_val_to_q31(p->multi_type==multi_noise ? p->multi_level : 0);
+      rec->params[p_vco2_sync] = ~p->sync;
+      rec->params[p_vco2_ring] = ~p->ring;
+      rec->params[p_vco2_cross] = param_val_to_q31(p->cross_mod_depth);
 //todo: drive
-//      s_params[p_drive] = 0;
-      if (timbre == timbre_main) {
-//      s_params[p_pitch_bend] = 0;
-      s_params[p_bend_range_pos] = p->bend_range_pos;
-      s_params[p_bend_range_neg] = p->bend_range_neg;
-      s_params[p_slider_assign] = p->joystick_assign_pos;
-      s_params[p_pedal_assign] = p->joystick_assign_neg;
+//      rec->params[p_drive] = 0;
+//      rec->params[p_pitch_bend] = 0;
+      rec->params[p_bend_range_pos] = p->bend_range_pos;
+      rec->params[p_bend_range_neg] = p->bend_range_neg;
+      rec->params[p_slider_assign] = p->joystick_assign_pos;
+      rec->params[p_pedal_assign] = p->joystick_assign_neg;
 //todo: joystick range pos & neg
-//      s_params[p_slider_range] = (p->joystick_range_pos - 100) * 0x0147AE14;
-//      s_params[p_pedal_range] = (p->joystick_range_neg - 100) * 0x0147AE14;
+//      rec->params[p_slider_range] = (p->joystick_range_pos - 100) * 0x0147AE14;
+//      rec->params[p_pedal_range] = (p->joystick_range_neg - 100) * 0x0147AE14;
 
 //todo: true dB level conversion
-      s_params[p_program_level] = p->program_level - 100;
-      if (s_params[p_program_level] >= 32)
-        s_params[p_program_level] = 0x7FFFFFFF; // +6dB
-      if (s_params[p_program_level] > 0)
-        s_params[p_program_level] *= 0x04000000; // (+0...+6dB)
-      else if (s_params[p_program_level] < 0)
-        s_params[p_program_level] *= 0x0145D174; // (-0dB...-18dB] 7/8 / 88
-      s_params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
-      s_params[p_bpm] = p->bpm;
-
-      s_seq_len = p->step_length;
-      s_seq_res = (k_samplerate * 150) << p->step_resolution;
-      s_seq_step_mask = p->step_mask;
+      rec->params[p_program_level] = p->program_level - 100;
+      if (rec->params[p_program_level] >= 32)
+        rec->params[p_program_level] = 0x7FFFFFFF; // +6dB
+      if (rec->params[p_program_level] > 0)
+        rec->params[p_program_level] *= 0x04000000; // (+0...+6dB)
+      else if (rec->params[p_program_level] < 0)
+        rec->params[p_program_level] *= 0x0145D174; // (-0dB...-18dB] 7/8 / 88
+      rec->params[p_keyboard_octave] = (p->keyboard_octave - 2) * 12;
+      rec->params[p_bpm] = p->bpm;
+
+      seq->len = p->step_length;
+      seq->res = (k_samplerate * 150) << p->step_resolution;
+      seq->step_mask = p->step_mask;
       for (uint32_t i = 0; i < SEQ_STEP_COUNT; i++) {
-        s_seq_note[i] = p->step_event_data[i].note[0];
-        s_seq_vel[i] = p->step_event_data[i].velocity[0];
-        if (p->step_event_data[i].gate[0].gate_time < 72)
-          s_seq_gate[i] = (uint32_t)(p->step_event_data[i].gate[0].gate_time) * 0x01C71C72;
-        else if (p->step_event_data[i].gate[0].gate_time == 72)
-          s_seq_gate[i] = 0x7FFFFFFF;
-//todo: tie
-//        else
-//
+        for (uint32_t n = 0; n < MNLGXD_POLY; n++) {
+          seq->note[i][n] = p->step_event_data[i].note[n];
+          seq->vel[i][n] = p->step_event_data[i].velocity[n];
+//tie is held for the full step, todo: legato into the next step
+          seq->gate[i][n] = p->step_event_data[i].gate[n].gate_time < SEQ_GATE_FULL ? p->step_event_data[i].gate[n].gate_time : SEQ_GATE_FULL;
+        }
         for (uint32_t j = 0; j < SEQ_MOTION_SLOT_COUNT; j++) {
           const motion_slot_param_t *motion_slot_param = &(p->motion_slot_param[j]);
           if ((p->motion_slot_step_mask[j] & (1 << i)) && motion_slot_param->motion_enable) {
             if (motion_slot_param->parameter_id >= MOTION_PARAM_LUT_FIRST && motion_slot_param->parameter_id <= MOTION_PARAM_LUT_LAST)
-             s_seq_motion_param[j] = motion_param_lut[s_prog_type][motion_slot_param->parameter_id - MOTION_PARAM_LUT_FIRST];
+             seq->motion_param[j] = motion_param_lut[rec->type][motion_slot_param->parameter_id - MOTION_PARAM_LUT_FIRST];
              else if (motion_slot_param->parameter_id == 126)
-              s_seq_motion_param[j] = p_pitch_bend;
+              seq->motion_param[j] = p_pitch_bend;
             else
-              s_seq_motion_param[j] = 0;
-            if (s_seq_motion_param[j]) {
+              seq->motion_param[j] = 0;
+            if (seq->motion_param[j]) {
 //todo: 10-bit motion data
 //todo: substep motion data
-              s_seq_motion_start[i][j] = p->step_event_data[i].motion_slot_data[j].value_hi[0];
+              seq->motion_start[i][j] = p->step_event_data[i].motion_slot_data[j].value_hi[0];
               if (motion_slot_param->smooth_enable)
-                s_seq_motion_diff[i][j] = p->step_event_data[i].motion_slot_data[j].value_hi[4] - s_seq_motion_start[i][j];
+                seq->motion_diff[i][j] = p->step_event_data[i].motion_slot_data[j].value_hi[4] - seq->motion_start[i][j];
               else
-                s_seq_motion_diff[i][j] = 0;
+                seq->motion_diff[i][j] = 0;
             }
           } else
-            s_seq_motion_param[j] = 0;
+            seq->motion_param[j] = 0;
         }
       }
-      }
     }; break;
     default:
       break;
   }
+  initSeqEvents(seq);
+}
+
+static const prog_rec_t *cacheProg(uint32_t index) {
+  uint32_t k, lru = 0;
+  for (k = 0; k < PROG_CACHE_SIZE; k++) {
+    if (s_progcache_used[k] && s_progcache[k].index == index)
+      break;
+//never evict the record the sequencer is playing
+    if (&s_progcache[k].seq != s_seq && (&s_progcache[lru].seq == s_seq || s_progcache_used[k] < s_progcache_used[lru]))
+      lru = k;
+  }
+  if (k == PROG_CACHE_SIZE)
+    decodeProg(&s_progcache[k = lru], index);
+  s_progcache_used[k] = ++s_progcache_stamp;
+  return &s_progcache[k];
+}
+
+static void updateVco(uint32_t i) {
+  const q31_t *p = &s_params[p_vco1_wave + i * 10];
+  s_vco.pitch[i] = p[p_vco1_pitch - p_vco1_wave] + (p[p_vco1_octave - p_vco1_wave] << 8);
+  s_vco.level[i] = p[p_vco1_level - p_vco1_wave];
+  s_vco.shape[i] = p[p_vco1_shape - p_vco1_wave];
+  s_vco.cross[i] = p[p_vco1_cross_stub - p_vco1_wave];
+  s_vco.wave[i] = (uint32_t)p[0] < wave_num ? p[0] : wave_num;
+  s_vco.chain[i] = (p[p_vco1_ring_stub - p_vco1_wave] ? 4 : 0) | (p[p_vco1_sync_stub - p_vco1_wave] ? 2 : 0) | (s_vco.cross[i] ? 1 : 0);
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void setParam(uint32_t index, q31_t value) {
+  s_params[index] = value;
+  if (index >= p_vco1_wave && index < p_vco1_wave + VCO_COUNT * 10)
+    updateVco((index - p_vco1_wave) / 10);
+}
+
+static void initVoice(uint32_t timbre) {
+  const prog_rec_t *rec = cacheProg(timbre == timbre_main ? s_prog : s_sub);
+
+  s_prog_type = rec->type;
+  if (timbre == timbre_main) {
+    for (uint32_t i = 0; i < p_num; i++)
+      if (i != p_pitch_bend)
+        s_params[i] = rec->params[i];
+    s_seq = &rec->seq;
+//the motion values are of the previous sequence steps
+    for (uint32_t i = 0; i < SEQ_MOTION_SLOT_COUNT; i++) {
+      s_seq_motion_start[i] = 0;
+      s_seq_motion_diff[i] = 0;
+    }
+    for (uint32_t i = 0; i < VCO_COUNT; i++)
+      updateVco(i);
+  } else {
+    for (uint32_t i = p_vco1_wave; i < p_vco4_wave; i++)
+      s_params[i + timbre_sub] = rec->params[i];
+    for (uint32_t i = 3; i < VCO_COUNT; i++)
+      updateVco(i);
+  }
+
   s_sub_balance = s_params[p_main_sub_balance] << 1;
   s_main_balance = -s_sub_balance;
   if (s_sub_balance < 0)
@@ -384,12 +521,88 @@ void initVoice(uint32_t timbre) {
 
 static inline __attribute__((optimize("Ofast"), always_inline))
 void initSeq() {
-  s_seq_step = SEQ_STEP_COUNT;
-  s_sample_pos = 0;
-  s_seq_quant = 0;
+  s_seq_event = 0;
+  s_seq_event_pos = 0;
+  s_seq_phase = 0;
+  s_seq_voices = 0;
+  s_seq_gate = 0;
   s_seq_started = false;
 }
 
+/*
+ * Step clock: the step phase runs from 0 to 0x80000000 with the increment
+ * taken from BPM and the program step resolution. It is only recalculated
+ * when any of them changes, BPM 0 stops the clock.
+ */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void seqClock() {
+  const uint32_t bpm = s_play_mode == mode_seq_nts1 ? fx_get_bpm() : s_params[p_bpm];
+  if (bpm == s_seq_bpm && s_seq->rcp == s_seq_rcp)
+    return;
+  s_seq_bpm = bpm;
+  s_seq_rcp = s_seq->rcp;
+//rounded up to never exceed the step length
+  s_seq_w0 = ((uint64_t)bpm * s_seq_rcp + 0x1FFFF) >> 17;
+  s_seq_k = s_seq_w0 ? 0xFFFFFFFF / s_seq_w0 : 0;
+}
+
+/*
+ * Process the sequencer events due at the current step phase.
+ * Returns the number of frames up to the next event, at most frames.
+ */
+static inline __attribute__((optimize("Ofast"), always_inline))
+uint32_t seqEvents(uint32_t frames) {
+  if (s_seq->event_count == 0) {
+    s_seq_gate = 0;
+    return frames;
+  }
+  seqClock();
+  while (s_seq_phase >= s_seq_event_pos) {
+    const seq_event_t *ev = &s_seq->event[s_seq_event];
+    if (ev->type == seq_event_gate_off) {
+      for (uint32_t v = 0; v < VOICE_COUNT; v++)
+        if ((ev->voices >> s_seq_slot[v]) & 1)
+          s_seq_gate &= ~(1 << v);
+    } else {
+//keep the overshoot to stay in time
+      if (s_seq_phase >= 0x80000000)
+        s_seq_phase -= 0x80000000;
+      s_seq_step = ev->step;
+//step notes go to the voices in order, a rest keeps the first note pitch
+      uint32_t v = 0;
+      s_seq_slot[0] = 0;
+      for (uint32_t n = 0; n < SEQ_POLY && v < VOICE_COUNT; n++)
+        if ((ev->voices >> n) & 1)
+          s_seq_slot[v++] = n;
+      s_seq_voices = (1 << v) - 1;
+      s_seq_gate = s_seq_voices;
+      for (uint32_t i = 0; i < VOICE_COUNT; i++)
+        s_seq_pitch[i] = (int32_t)s_seq->note[s_seq_step][s_seq_slot[i]] << 8;
+      if (!s_seq_started && s_seq_gate) {
+        s_seq_transpose = s_note_pitch - s_seq_pitch[0];
+        s_seq_started = true;
+      }
+      for (uint32_t i = 0; i < SEQ_MOTION_SLOT_COUNT; i++) {
+        if (s_seq->motion_param[i]) {
+          s_seq_motion_start[i] = (q31_t)s_seq->motion_start[s_seq_step][i] << 23;
+          s_seq_motion_diff[i] = (q31_t)s_seq->motion_diff[s_seq_step][i] << 23;
+        }
+      }
+    }
+    if (++s_seq_event >= s_seq->event_count)
+      s_seq_event = 0;
+    ev = &s_seq->event[s_seq_event];
+    s_seq_event_pos = ev->type == seq_event_gate_off ? ev->gate * 0x01C71C72 : 0x80000000; // 1/72
+  }
+  if (s_seq_w0 == 0)
+    return frames;
+  const uint32_t d = s_seq_event_pos - s_seq_phase;
+  uint32_t n = ((uint64_t)d * s_seq_k) >> 32;
+  while (n * s_seq_w0 < d)
+    n++;
+  return n < frames ? n : frames;
+}
+
 static inline __attribute__((optimize("Ofast"), always_inline))
 q31_t getVco(q31_t phase, uint32_t wave, q31_t shape) {
   q31_t t1, t2, out;
@@ -419,7 +632,7 @@ q31_t getVco(q31_t phase, uint32_t wave, q31_t shape) {
       out <<= 2;
       break;
     case wave_noise:
-      out = f32_to_q31(osc_white());
+      out = noise_whiteq();
       break;
     default:
       out = 0;
@@ -428,57 +641,233 @@ q31_t getVco(q31_t phase, uint32_t wave, q31_t shape) {
   return out;
 }
 
-void OSC_INIT(uint32_t platform, __attribute__((unused)) uint32_t api)
-{
-  s_platform = platform;
+//block constant parameters of a VCO
+typedef struct {
+  q31_t w0;
+  q31_t shape;
+  q31_t level;
+  q31_t cross;
+  uint32_t chain; //ring << 2 | sync << 1 | cross
+  uint32_t k; //phase distance to fraction of a sample
+  uint32_t sync_w0; //previous VCO ones for the sync reset fraction
+  uint32_t sync_k;
+  uint32_t edge_count;
+  q31_t edge[VCO_EDGE_COUNT]; //step or slope discontinuity phase
+  q31_t edge_amp[VCO_EDGE_COUNT]; //half of the step or of the slope change per sample
+} vco_t;
+
+typedef void (*vco_cycle_t)(const vco_t *v, q31_t *phase, q31_t *blep, q31_t * __restrict out, q31_t * __restrict pos, q31_t * __restrict y, uint32_t frames);
+
+/*
+ * One VCO over a chunk of frames. On entry out and pos hold the previous VCO
+ * output and unwrapped phase, on exit they hold this VCO ones for the next VCO.
+ * The output is accumulated to y. wave_num renders silence, keeping the phase
+ * and the sync/cross chain running.
+ */
+template<uint32_t wave, bool ring, bool sync, bool cross>
+static void vcoCycle(const vco_t *v, q31_t *phase, __attribute__((unused)) q31_t *blep, q31_t * __restrict out, q31_t * __restrict pos, q31_t * __restrict y, uint32_t frames) {
+  const q31_t w0 = v->w0;
+  const q31_t shape = v->shape;
+  const q31_t level = v->level;
+  const q31_t depth = v->cross;
+  q31_t ph = *phase;
+  q31_t noise[wave == wave_noise ? VCO_BLOCK : 1];
+  if (wave == wave_noise)
+    noise_white_fillq(noise, frames);
+  for (uint32_t f = 0; f < frames; f++) {
+    q31_t val = wave == wave_num ? 0 : wave == wave_noise ? noise[f] : getVco(ph, wave, shape);
+    if (ring)
+      val = q31mul(val, out[f]);
+    if (wave != wave_num)
+      y[f] = q31add(y[f], q31mul(val, level));
+    if (sync && pos[f] <= 0)
+      ph = pos[f];
+    else if (cross)
+      ph += w0 + q31mul(out[f], depth);
+    else
+      ph += w0;
+    out[f] = val;
+    pos[f] = ph;
+    ph &= 0x7FFFFFFF;
+  }
+  *phase = ph;
 }
 
-void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames)
-{
-  q31_t out[VCO_COUNT];
-  q31_t w0[VCO_COUNT];
-  q31_t level[VCO_COUNT];
-  q31_t val, main_vol, sub_vol;
-  int32_t pitch1, pitch3 = params->pitch;
-  uint32_t vco_start, vco_active;
-
-  if (s_play_mode != mode_note) {
-    if (s_sample_pos >= s_seq_quant) {
-      s_sample_pos = 0;
-      if (++s_seq_step >= s_seq_len) {
-        s_seq_step = 0;
-        s_seq_step_bit = 1;
-      } else {
-        s_seq_step_bit <<= 1;
-      }  
-      s_seq_quant = s_seq_res / (s_play_mode == mode_seq_nts1 ? fx_get_bpm() : s_params[p_bpm]);
-//bug: previous program influence on gate length
-      s_seq_gate_len = q31mul(s_seq_quant, s_seq_gate[s_seq_step]);
-      s_seq_gate_on = ((s_seq_step_mask & s_seq_step_bit) && s_seq_vel[s_seq_step]);
-      s_seq_step_pitch = (uint32_t)s_seq_note[s_seq_step] << 8;
-      if (!s_seq_started && s_seq_gate_on) {
-        s_seq_transpose = s_note_pitch - s_seq_step_pitch;
-        s_seq_started = true;
-      }
-      for (uint32_t i = 0; i < SEQ_MOTION_SLOT_COUNT; i++) {
-        if (s_seq_motion_param[i]) {
-          s_seq_motion_value[i] = (q31_t)s_seq_motion_start[s_seq_step][i] << 23;
-          s_seq_motion_delta[i] = ((q31_t)s_seq_motion_diff[s_seq_step][i] << 23) / s_seq_quant;
+/*
+ * Band-limited VCO: the naive waveform corrected with 2-point PolyBLEP residuals
+ * at the steps and PolyBLAMP residuals at the triangle corners. Hard sync reset
+ * step is spread over the samples around the master VCO wrap, the part after it
+ * is kept in blep till the next sample. Ring and cross are not specialized here.
+ */
+template<uint32_t wave, bool sync>
+static void vcoBlep(const vco_t *v, q31_t *phase, q31_t *blep, q31_t * __restrict out, q31_t * __restrict pos, q31_t * __restrict y, uint32_t frames) {
+  const q31_t w0 = v->w0;
+  const q31_t shape = v->shape;
+  const q31_t level = v->level;
+  const q31_t depth = v->cross;
+  const uint32_t k = v->k;
+  const bool ring = v->chain & 4;
+  q31_t ph = *phase;
+  q31_t next = *blep;
+  for (uint32_t f = 0; f < frames; f++) {
+    q31_t val = getVco(ph, wave, shape);
+    q31_t corr = next;
+    const bool reset = next != 0;
+    next = 0;
+    if (sync && pos[f] <= 0) {
+      const uint32_t p = pos[f] & 0x7FFFFFFF;
+      q31_t t = p < v->sync_w0 ? p * v->sync_k : 0x7FFFFFFF;
+      const q31_t h = (getVco(p, wave, shape) >> 1) - (getVco((ph + w0) & 0x7FFFFFFF, wave, shape) >> 1);
+      corr += q31mul(h, q31mul(t, t));
+      t = 0x7FFFFFFF - t;
+      next = -q31mul(h, q31mul(t, t));
+    }
+//the sample after a sync reset has no own discontinuities passed
+    if (!reset) {
+      for (uint32_t e = 0; e < v->edge_count; e++) {
+//one sample around the edge at most
+        uint32_t d = (ph - v->edge[e] + w0) & 0x7FFFFFFF;
+        if (d >= (uint32_t)w0 << 1)
+          continue;
+        const bool after = d >= (uint32_t)w0;
+        d = after ? d - w0 : w0 - d;
+        const q31_t x = 0x7FFFFFFF - d * k;
+        if (wave == wave_tri) {
+          corr += q31mul(v->edge_amp[e], q31mul(q31mul(x, x), q31mul(x, 0x2AAAAAAB))); // (1-x)^3/3
+        } else if (after) {
+          corr -= q31mul(v->edge_amp[e], q31mul(x, x));
+        } else {
+          corr += q31mul(v->edge_amp[e], q31mul(x, x));
         }
       }
     }
-    pitch3 += s_seq_step_pitch + s_seq_transpose - s_note_pitch;
+    val = q31add(val, corr);
+    if (ring)
+      val = q31mul(val, out[f]);
+    y[f] = q31add(y[f], q31mul(val, level));
+    if (sync && pos[f] <= 0)
+      ph = pos[f];
+    else
+      ph += w0 + q31mul(out[f], depth);
+    out[f] = val;
+    pos[f] = ph;
+    ph &= 0x7FFFFFFF;
+  }
+  *phase = ph;
+  *blep = next;
+}
+
+#define VCOCYCLE8(w) { \
+  vcoCycle<w, false, false, false>, vcoCycle<w, false, false, true>, vcoCycle<w, false, true, false>, vcoCycle<w, false, true, true>, \
+  vcoCycle<w, true, false, false>, vcoCycle<w, true, false, true>, vcoCycle<w, true, true, false>, vcoCycle<w, true, true, true> \
+}
+#define VCOBLEP8(w) { \
+  vcoBlep<w, false>, vcoBlep<w, false>, vcoBlep<w, true>, vcoBlep<w, true>, \
+  vcoBlep<w, false>, vcoBlep<w, false>, vcoBlep<w, true>, vcoBlep<w, true> \
+}
+//indexed by quality, wave and chain
+static const vco_cycle_t vco_cycle_lut[quality_num][wave_num + 1][8] = {
+  {
+    VCOCYCLE8(wave_sqr),
+    VCOCYCLE8(wave_tri),
+    VCOCYCLE8(wave_saw),
+    VCOCYCLE8(wave_noise),
+    VCOCYCLE8(wave_num)
+  }, {
+    VCOBLEP8(wave_sqr),
+    VCOBLEP8(wave_tri),
+    VCOBLEP8(wave_saw),
+    VCOCYCLE8(wave_noise),
+    VCOCYCLE8(wave_num)
+  }
+};
+#undef VCOBLEP8
+#undef VCOCYCLE8
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void vcoEdge(vco_t *v, q31_t phase, q31_t amp) {
+  v->edge[v->edge_count] = phase & 0x7FFFFFFF;
+  v->edge_amp[v->edge_count++] = amp;
+}
+
+//step height is taken from the naive waveform itself, continuous points are skipped
+static inline __attribute__((optimize("Ofast"), always_inline))
+void vcoStep(vco_t *v, uint32_t wave, q31_t phase) {
+  const q31_t h = (getVco(phase, wave, v->shape) >> 1) - (getVco((phase - 1) & 0x7FFFFFFF, wave, v->shape) >> 1);
+  if (h > VCO_EDGE_MIN || h < -VCO_EDGE_MIN)
+    vcoEdge(v, phase, h);
+}
+
+//1/(1 + 2 * x)/2 for x in [0, 1.0], triangle fold points
+static const q31_t fold_rcp_lut[33] = {
+  0x40000000, 0x3C3C3C3C, 0x38E38E39, 0x35E50D79, 0x33333333, 0x30C30C31,
+  0x2E8BA2E9, 0x2C8590B2, 0x2AAAAAAB, 0x28F5C28F, 0x27627627, 0x25ED097B,
+  0x24924925, 0x234F72C2, 0x22222222, 0x21084211, 0x20000000, 0x1F07C1F0,
+  0x1E1E1E1E, 0x1D41D41D, 0x1C71C71C, 0x1BACF915, 0x1AF286BD, 0x1A41A41A,
+  0x1999999A, 0x18F9C190, 0x18618618, 0x17D05F41, 0x1745D174, 0x16C16C17,
+  0x1642C859, 0x15C9882C, 0x15555555
+};
+
+//interpolated LUT seed refined with one Newton step r += r * (1 - d * r), d = 1 + 2 * shape
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t foldRcp(q31_t shape) {
+  const uint32_t x0 = shape >> 26;
+  const q31_t r = linintq((shape << 5) & 0x7FFFFFFF, fold_rcp_lut[x0], fold_rcp_lut[x0 + 1]);
+  const q31_t e = 0x10000000 - q31mul(0x20000000 + (shape >> 1), r); //(1 - d * r)/8
+  return r + q31mul(r, e << 3);
+}
+
+static void initVcoEdges(vco_t *v, uint32_t wave) {
+  q31_t t;
+  v->edge_count = 0;
+  v->k = v->w0 > 0 ? 0x7FFFFFFF / v->w0 : 0;
+  switch (wave) {
+    case wave_sqr:
+      vcoStep(v, wave, 0);
+      vcoStep(v, wave, 0x40000000 - q31mul(0x3F000000, v->shape));
+      break;
+    case wave_saw:
+      t = q31mul(0x20000000, v->shape);
+      vcoStep(v, wave, 0);
+      vcoStep(v, wave, 0x40000000 - t);
+      vcoStep(v, wave, 0x40000000);
+      vcoStep(v, wave, 0x40000001 + t);
+      break;
+    case wave_tri: {
+//slope is 4 * (1 + 2 * shape) per cycle, it changes the sign at the corners and at the fold points
+      int64_t amp = ((int64_t)v->w0 * (0x80000000LL + 2LL * (v->shape > 0 ? v->shape : 0))) >> 29;
+      t = amp > 0x7FFFFFFF ? 0x7FFFFFFF : amp;
+      if (v->shape > 0) {
+        const q31_t a = foldRcp(v->shape) >> 1;
+        vcoEdge(v, 0, -t);
+        vcoEdge(v, 0x20000000 - a, t);
+        vcoEdge(v, 0x20000000 + a, -t);
+        vcoEdge(v, 0x40000000, t);
+        vcoEdge(v, 0x60000000 - a, -t);
+        vcoEdge(v, 0x60000000 + a, t);
+      } else {
+        vcoEdge(v, 0, t);
+        vcoEdge(v, 0x40000000, -t);
+      }
+    }; break;
+    default:
+      break;
   }
+}
 
+//apply the current motion values to their parameters
+static inline __attribute__((optimize("Ofast"), always_inline))
+void seqMotion() {
   for (uint32_t i = 0; i < SEQ_MOTION_SLOT_COUNT; i++) {
-    int8_t val = s_seq_motion_value[i] >> 23;
-    switch (s_seq_motion_param[i]) {
+    const q31_t value = s_seq_motion_start[i] + q31mul(s_seq_motion_diff[i], s_seq_phase);
+    int8_t val = value >> 23;
+    switch (s_seq->motion_param[i]) {
       case p_pitch_bend:
-        s_params[s_seq_motion_param[i]] = val << 1;
+        setParam(s_seq->motion_param[i], val << 1);
         break;
       case p_vco1_pitch:
       case p_vco2_pitch:
-        s_params[s_seq_motion_param[i]] = getPitch(s_seq_motion_value[i] >> 21);
+        setParam(s_seq->motion_param[i], getPitch(value >> 21));
         break;
       case p_vco2_wave:
         if (s_prog_type == monologue_ID && val == wave_sqr)
@@ -486,105 +875,212 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
       case p_vco1_wave:
       case p_vco1_octave:
       case p_vco2_octave:
-        s_params[s_seq_motion_param[i]] = (val - 1) * 12;
+        setParam(s_seq->motion_param[i], (val - 1) * 12);
         break;
       case p_vco2_ring:
       case p_vco2_sync:
         if (s_prog_type == monologue_ID || s_prog_type == prologue_ID) {
-          s_params[p_vco2_ring] = val==0;
-          s_params[p_vco2_sync] = val==2;
+          setParam(p_vco2_ring, val==0);
+          setParam(p_vco2_sync, val==2);
         } else
-          s_params[s_seq_motion_param[i]] = ~val;
+          setParam(s_seq->motion_param[i], ~val);
         break;
       default:
-        s_params[s_seq_motion_param[i]] = s_seq_motion_value[i];
+        setParam(s_seq->motion_param[i], value);
       case 0:
         break;
     }
-    s_seq_motion_value[i] = q31add(s_seq_motion_value[i], s_seq_motion_delta[i]);
   }
+}
+
+//1/sqrt(voices) to keep the chord loudness
+static const q31_t voice_gain_lut[VOICE_COUNT] = {
+  0x7FFFFFFF, 0x5A82799A, 0x49E69D16, 0x40000000
+};
+
+/*
+ * Render a segment with no sequencer events inside. Voices and gate are voice
+ * bit masks, the VCO parameters not depending on the pitch are shared by them.
+ */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void renderVcos(const int32_t *pitch, uint32_t voices, uint32_t gate, q31_t * __restrict y, uint32_t frames) {
+  vco_t vco[VCO_COUNT];
+  vco_cycle_t cycle[VCO_COUNT];
+  int32_t offset[VCO_COUNT];
+  const uint32_t vco_count = VCO_COUNT >> (1 - s_params[p_sub_on]);
+  int32_t bend;
 
   if (s_params[p_pitch_bend] >=0 )
-    pitch3 += s_params[p_pitch_bend] * s_params[p_bend_range_pos];
+    bend = s_params[p_pitch_bend] * s_params[p_bend_range_pos];
   else
-    pitch3 += s_params[p_pitch_bend] * s_params[p_bend_range_neg];
-
-  vco_start = 0;
-  vco_active = VCO_COUNT >> (1 - s_params[p_sub_on]);
-  main_vol = s_main_balance;
-  sub_vol = s_sub_balance;
-  if (s_params[p_sub_on]) {
-    switch (s_params[p_timbre_type]) {
-      case timbre_xfade:
-//todo: check&implement xfade main/sub position control
-        main_vol = pitch3 * 0x00010204; // 1/(127*256)
-        sub_vol = 0x7FFFFFFF - main_vol;
-        break;
-      case timbre_split:
-        if (((s_params[p_split_point] >= (pitch3 >> 8)) && !s_params[p_main_sub_position])
-          || ((s_params[p_split_point] < (pitch3 >> 8)) && s_params[p_main_sub_position])
-        ) {
-          main_vol = 0x7FFFFFFF;
-          vco_active = 3;
-        } else {
-          sub_vol = 0x7FFFFFFF;
-          vco_start = 3;
-        }
-        break;
-      default:
-        break;
-    }
+    bend = s_params[p_pitch_bend] * s_params[p_bend_range_neg];
+
+//keep the first voices fitting the VCO budget
+  uint32_t keep = 0;
+  for (uint32_t k = s_vco_budget / vco_count; voices && k; k--, voices &= voices - 1)
+    keep |= voices & -voices;
+  voices = keep ? keep : 1;
+
+  uint32_t drop = governor_level();
+  const uint32_t quality = drop ? quality_naive : s_quality;
+  if (drop && s_quality != quality_naive)
+    drop--;
+  for (; drop && (voices & (voices - 1)); drop--)
+    voices &= ~(0x80000000 >> __builtin_clz(voices));
+
+//the naive VCOs do not keep the sync residuals, drop them on the quality switch
+  if (quality != s_vco_quality) {
+    for (uint32_t k = 0; k < VOICE_COUNT; k++)
+      for (uint32_t i = 0; i < VCO_COUNT; i++)
+        s_blep[k][i] = 0;
+    s_vco_quality = quality;
   }
 
-  for (uint32_t i = vco_start; i < vco_active; i++) {
-    pitch1 = pitch3 + s_params[p_vco1_pitch + i * 10];
-    w0[i] = f32_to_q31(osc_w0f_for_note((pitch1 >> 8) + s_params[p_vco1_octave + i * 10] + s_params[p_keyboard_octave], pitch1 & 0xFF));
-    if (s_params[p_vco1_wave + i * 10] == wave_saw)
-      w0[i] >>= 1;
-    level[i] = s_params[p_vco1_level + i * 10];
-    if (p_sub_on)
-      level[i] = q31mul(level[i], i < 3 ? main_vol : sub_vol);
+  for (uint32_t i = 0; i < vco_count; i++) {
+    vco_t *v = &vco[i];
+    offset[i] = s_vco.pitch[i] + (s_params[p_keyboard_octave] << 8) + bend;
+    v->shape = s_vco.shape[i];
   }
 
-  q31_t * __restrict y = (q31_t *)yn;
-  for (uint32_t f = frames; f--; y++) {
-    val = 0;
-    if (s_play_mode == mode_seq && (!s_seq_gate_on || s_sample_pos >= s_seq_gate_len)) {
-      for (uint32_t i = vco_start; i < vco_active; i++)
-        out[i] = 0;
-    } else {
-      for (uint32_t i = vco_start; i < vco_active; i++) {
-        out[i] = getVco(s_phase[i], s_params[p_vco1_wave + i * 10], s_params[p_vco1_shape + i * 10]);
-        if (i && s_params[p_vco1_ring_stub + i * 10])
-          out[i] = q31mul(out[i], out[i - 1]);
-//        val = q31add(val, q31mul(out[i], s_params[p_vco1_level + i * 10]));
-        val = q31add(val, q31mul(out[i], level[i]));
+  for (uint32_t j = 0; j < frames; j++)
+    y[j] = 0;
+
+  const q31_t gain = voice_gain_lut[__builtin_popcount(voices) - 1];
+  for (; voices; voices &= voices - 1) {
+    const uint32_t k = __builtin_ctz(voices);
+    const int32_t pitch3 = pitch[k] + bend;
+    uint32_t vco_start = 0;
+    uint32_t vco_active = vco_count;
+    q31_t main_vol = s_main_balance;
+    q31_t sub_vol = s_sub_balance;
+    if (s_params[p_sub_on]) {
+      switch (s_params[p_timbre_type]) {
+        case timbre_xfade:
+//todo: check&implement xfade main/sub position control
+          main_vol = pitch3 * 0x00010204; // 1/(127*256)
+          sub_vol = 0x7FFFFFFF - main_vol;
+          break;
+        case timbre_split:
+          if (((s_params[p_split_point] >= (pitch3 >> 8)) && !s_params[p_main_sub_position])
+            || ((s_params[p_split_point] < (pitch3 >> 8)) && s_params[p_main_sub_position])
+          ) {
+            main_vol = 0x7FFFFFFF;
+            vco_active = 3;
+          } else {
+            sub_vol = 0x7FFFFFFF;
+            vco_start = 3;
+          }
+          break;
+        default:
+          break;
       }
-      val = q31add(val, q31mul(val, s_params[p_program_level]));
     }
 
-    *y = val;
+    if (drop < vco_active - vco_start)
+      vco_active -= drop;
+    else
+      vco_active = vco_start + 1;
 
     for (uint32_t i = vco_start; i < vco_active; i++) {
-      if (i == 0)
-        s_phase[i] += w0[i];
-      else if (s_params[p_vco1_sync_stub + i * 10] && s_phase[i - 1] <= 0)
-        s_phase[i] = s_phase[i - 1];
-      else
-        s_phase[i] += w0[i] + q31mul(out[i - 1], s_params[p_vco1_cross_stub + i * 10]);
+      vco_t *v = &vco[i];
+      const int32_t pitch1 = pitch[k] + offset[i];
+      v->w0 = osc_w0q_for_pitch(pitch1);
+      if (s_vco.wave[i] == wave_saw)
+        v->w0 >>= 1;
+      v->level = s_vco.level[i];
+      if (s_params[p_sub_on])
+        v->level = q31mul(v->level, i < 3 ? main_vol : sub_vol);
+      if (gain != 0x7FFFFFFF)
+        v->level = q31mul(v->level, gain);
+//the first active VCO has nothing to be chained to
+      const uint32_t chain = i == vco_start ? 0 : s_vco.chain[i];
+      v->chain = chain;
+      v->cross = chain & 1 ? s_vco.cross[i] : 0;
+      if (quality == quality_blep) {
+//the residual is left by a sync reset only, not to be applied once the sync is off
+        if (!(chain & 2))
+          s_blep[k][i] = 0;
+        initVcoEdges(v, s_vco.wave[i]);
+        if (i > vco_start) {
+          v->sync_w0 = vco[i - 1].w0;
+          v->sync_k = vco[i - 1].k;
+        }
+      }
+      cycle[i] = (gate >> k) & 1 ? vco_cycle_lut[quality][s_vco.wave[i]][chain] : vco_cycle_lut[quality_naive][wave_num][chain & 3];
     }
-    for (uint32_t i = vco_start; i < vco_active; i++)
-      s_phase[i] &= 0x7FFFFFFF;
 
-    s_sample_pos++;
+    q31_t * __restrict yv = y;
+    for (uint32_t n, f = 0; f < frames; f += n, yv += n) {
+      q31_t out[VCO_BLOCK];
+      q31_t pos[VCO_BLOCK];
+      n = frames - f < VCO_BLOCK ? frames - f : VCO_BLOCK;
+      for (uint32_t i = vco_start; i < vco_active; i++)
+        cycle[i](&vco[i], &s_phase[k][i], &s_blep[k][i], out, pos, yv, n);
+    }
+  }
+
+  for (uint32_t j = 0; j < frames; j++)
+    y[j] = q31add(y[j], q31mul(y[j], s_params[p_program_level]));
+}
 
+void OSC_INIT(uint32_t platform, __attribute__((unused)) uint32_t api)
+{
+  s_platform = platform;
+  s_vco_budget = (platform & k_user_target_platform_mask) == k_user_target_nutektdigital ? VCO_BUDGET_NTS1 : VCO_BUDGET;
+  initProgIndex();
+  initPitchLut();
+  osc_api_initq();
+  for (uint32_t k = PROG_CACHE_SIZE; k--;)
+    s_progcache_used[k] = 0;
+//the first programs are decoded up front, so selecting them never decodes in OSC_PARAM
+  for (uint32_t i = 0; i < PROG_CACHE_SIZE && i < s_prog_count; i++)
+    cacheProg(i);
+  noise_initq(k_noiseq_seed);
+  governor_init(platform, GOVERNOR_LEVELS);
+  PERF_INIT("sequencer", "VCO");
+}
+
+void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames)
+{
+  PERF_BLOCK_BEGIN();
+  governor_start();
+  q31_t * __restrict y = (q31_t *)yn;
+//the block is split at the sequencer events
+  for (uint32_t n, f = 0; f < frames; f += n, y += n) {
+    int32_t pitch[VOICE_COUNT];
+    uint32_t voices = 1, gate = 1;
+    PERF_SECTION(perf_seq);
+    n = frames - f;
+    if (s_play_mode == mode_note) {
+      pitch[0] = params->pitch;
+    } else {
+      n = seqEvents(n);
+      for (uint32_t v = 0; v < VOICE_COUNT; v++)
+        pitch[v] = params->pitch + s_seq_pitch[v] + s_seq_transpose - s_note_pitch;
+//the first voice keeps running in rests like the mono one
+      voices = s_seq_voices | 1;
+      gate = s_play_mode == mode_seq ? s_seq_gate : voices;
+    }
+//an empty sequence has no steps to run the phase and the motion over
+    if (s_seq->event_count)
+      seqMotion();
+    PERF_SECTION(perf_vco);
+    renderVcos(pitch, voices, gate, y, n);
+    if (s_play_mode != mode_note && s_seq->event_count)
+      s_seq_phase += s_seq_w0 * n;
   }
+  governor_stop(frames);
+  PERF_BLOCK_END(frames);
 }
 
 void OSC_NOTEON(__attribute__((unused)) const user_osc_param_t * const params)
 {
-  for (uint32_t i = 0; i < VCO_COUNT; i++)
-    s_phase[i] = 0;
+  for (uint32_t v = 0; v < VOICE_COUNT; v++) {
+    for (uint32_t i = 0; i < VCO_COUNT; i++) {
+      s_phase[v][i] = 0;
+      s_blep[v][i] = 0;
+    }
+  }
   s_note_pitch = params->pitch;
 //  s_tie = false;
   initSeq();
@@ -682,7 +1178,7 @@ void OSC_PARAM(uint16_t index, uint16_t value)
           param = param_val_to_q31(value);
           break;
       }
-      s_params[index] = param;
+      setParam(index, param);
       break;
     case k_user_osc_param_id1:
       if (s_prog != value) {
@@ -708,7 +1204,7 @@ void OSC_PARAM(uint16_t index, uint16_t value)
        s_assignable[index - k_user_osc_param_id4] = value;
       break;
     case k_user_osc_param_id6:
-
+      s_quality = value < quality_num ? value : quality_naive;
       break;
     default:
       break;
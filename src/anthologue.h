@@ -24,6 +24,7 @@
 #define SEQ_MOTION_SLOT_COUNT 4
 #define MNLG_POLY 4
 #define MNLGXD_POLY 8
+#define SEQ_POLY MNLGXD_POLY //step notes at most
 
 #define MOTION_PARAM_LUT_FIRST 13
 #define MOTION_PARAM_LUT_LAST 41
@@ -663,6 +664,12 @@ enum {
   mode_seq_nts1,
 };
 
+enum {
+  quality_naive = 0,
+  quality_blep,
+  quality_num
+};
+
 static const uint8_t motion_param_lut[4][MOTION_PARAM_LUT_LAST - MOTION_PARAM_LUT_FIRST + 1] = {
   { //mnlg
     0, 0, 0, 0,
@@ -878,24 +885,48 @@ static const struct {
 static const __attribute__((used, section(".hooks")))
 uint8_t logue_prog[BANK_SIZE * sizeof(mnlgxd_prog_t)] = {};
 
-static inline __attribute__((optimize("Ofast"), always_inline))
-const void *getProg(uint32_t index, uint8_t *prog_type) {
+#define PROG_MAX (sizeof(logue_prog) / sizeof(prlg_prog_t)) //the smallest program type
+
+//program bank index, built once with initProgIndex()
+static struct {
+  const void *ptr;
+  uint8_t type;
+} s_prog_index[PROG_MAX + 1];
+static uint32_t s_prog_count;
+
+static void initProgIndex() {
   const uint32_t *prog_ptr = (uint32_t*)logue_prog;
-  uint8_t i, j = 0;
-  for (i = 0; i <= index && j < num_ID; i++) {
-    if (i > 0)
-      prog_ptr += prog_seek[j].size;
+  const uint32_t *prog_end = (uint32_t*)(logue_prog + sizeof(logue_prog));
+  uint32_t j = 0;
+  for (s_prog_count = 0; s_prog_count < PROG_MAX; s_prog_count++) {
     for (j = 0; j < num_ID; j++) {
-      if (prog_ptr[prog_seek[j].offset] == prog_seek[j].mark)
+      if (prog_ptr + prog_seek[j].size <= prog_end && prog_ptr[prog_seek[j].offset] == prog_seek[j].mark)
         break;
     }
+    if (j == num_ID)
+      break;
+    s_prog_index[s_prog_count].ptr = prog_ptr;
+    s_prog_index[s_prog_count].type = j;
+    prog_ptr += prog_seek[j].size;
   }
-  *prog_type = j;
-  return prog_ptr;
+//out of range index resolves to the terminating entry of unknown type
+  s_prog_index[s_prog_count].ptr = prog_ptr;
+  s_prog_index[s_prog_count].type = num_ID;
 }
 
-//static inline __attribute__((optimize("Ofast"), always_inline))
-int32_t getPitch(uint16_t pitch) {
+static inline __attribute__((optimize("Ofast"), always_inline))
+const void *getProg(uint32_t index, uint8_t *prog_type) {
+  if (index > s_prog_count)
+    index = s_prog_count;
+  *prog_type = s_prog_index[index].type;
+  return s_prog_index[index].ptr;
+}
+
+#define PITCH_LUT_SIZE 1024
+
+static int16_t s_pitch_lut[PITCH_LUT_SIZE]; //10-bit pitch knob value to 1/256 semitone, built once with initPitchLut()
+
+static int32_t calcPitch(uint16_t pitch) {
 //todo: better pitch calculation implementation
   int32_t res;
   if (pitch < 4)
@@ -918,3 +949,13 @@ int32_t getPitch(uint16_t pitch) {
     res = 1200;
   return res * 256 / 100;
 }
+
+static void initPitchLut() {
+  for (uint32_t i = 0; i < PITCH_LUT_SIZE; i++)
+    s_pitch_lut[i] = calcPitch(i);
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+int32_t getPitch(uint16_t pitch) {
+  return s_pitch_lut[pitch < PITCH_LUT_SIZE ? pitch : PITCH_LUT_SIZE - 1];
+}
@@ -14,11 +14,20 @@
 #define OSC_NOTE_Q
 #define OSC_SAW_Q
 #include "osc_apiq.h"
+#include "exp2q.h"
+#include "governor.h"
+#include "perf.h"
 
 #define MAX_UNISON 12 //maximum unison pairs
 #define MAX_DETUNE 1.f //maximum detune between neighbor unison voices in semitones
 #define MAX_POLY 12 //maximum polyphony
 #define NOPITCH 0xFFFF
+#define GOVERNOR_LEVELS 4 //unison pairs limit is halved by each level
+
+enum {
+  perf_w0,
+  perf_render,
+};
 
 static float s_unison;
 static float s_detune;
@@ -40,7 +49,7 @@ static q31_t s_phase[MAX_POLY][MAX_UNISON * 2 + 1];
 static q31_t s_w0[MAX_POLY][MAX_UNISON * 2 + 1];
 static uint16_t s_pitch[MAX_POLY];
 
-void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused)) uint32_t api)
+void OSC_INIT(uint32_t platform, __attribute__((unused)) uint32_t api)
 {
   s_unison = 0.f;
   s_detune = 0.f;
@@ -58,10 +67,13 @@ void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused))
   s_old_pitch = NOPITCH;
   s_osc_pitch = NOPITCH;
   osc_api_initq();
+  exp2_initq();
+  governor_init(platform, GOVERNOR_LEVELS);
+  PERF_INIT("w0", "render");
 }
 
-__fast_inline float osc_w0f_for_notef(uint8_t note, float mod) {
-  return clipmaxf(linintf(mod, osc_notehzf(note), osc_notehzf(note + 1)), k_note_max_hz) * k_samplerate_recipf;
+__fast_inline q31_t osc_w0q_for_notef(uint8_t note, float mod) {
+  return clipmaxq(osc_w0q_for_note_exp2(note, f32_to_q31(mod)), k_note_max_hzq);
 }
 
 void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames)
@@ -73,6 +85,10 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
   bool has_frac;
   q31_t valq, *w0, *phase;
 
+  PERF_BLOCK_BEGIN();
+  PERF_SECTION(perf_w0);
+  governor_start();
+
   if (s_note_pitch != s_old_pitch || params->pitch != s_osc_pitch) {
     pitch = params->pitch - s_osc_pitch + s_old_pitch;
     s_old_pitch = s_note_pitch;
@@ -91,6 +107,7 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
     frac = clipminmaxf(.0f, s_unison + lfo * s_max_unison, MAX_UNISON);
   else 
     frac = s_unison;
+  frac = clipmaxf(frac, MAX_UNISON >> governor_level());
 
   base = (uint32_t)frac;
   frac -= base;
@@ -113,13 +130,14 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
       n2 -= detune;
       b1 = (uint32_t)n1;
       b2 = (uint32_t)n2;
-      *w0++ = f32_to_q31(osc_w0f_for_notef(b1, n1 - b1));
-      *w0++ = f32_to_q31(osc_w0f_for_notef(b2, n2 - b2));
+      *w0++ = osc_w0q_for_notef(b1, n1 - b1);
+      *w0++ = osc_w0q_for_notef(b2, n2 - b2);
     }
   }
 
   q31_t fracq = q31mul(f32_to_q31(frac), s_amp);
 
+  PERF_SECTION(perf_render);
   q31_t * __restrict y = (q31_t *)yn;
   for (uint32_t f = frames; f--; y++) {
     valq = 0;
@@ -149,6 +167,9 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
       *phase++ += frames * *w0++;
     }
   }
+
+  governor_stop(frames);
+  PERF_BLOCK_END(frames);
 }
 
 void OSC_NOTEON(const user_osc_param_t * const params)
@@ -10,8 +10,11 @@
 
 #include "userosc.h"
 #include "fixed_mathq.h"
+#include "exp2q.h"
 
 #include "fm64.h"
+#include "governor.h"
+#include "perf.h"
 
 #define USE_Q31
 #ifdef USE_Q31 //use fixed-point math to reduce CPU consumption
@@ -33,12 +36,16 @@
   typedef q31_t param_t;
   #define f32_to_param(a) f32_to_q31(a)
   #define param_to_q31(a) (a)
+  #define param_to_f32(a) q31_to_f32(a)
+  #define q31_to_param(a) (a)
   #define param_add(a,b) q31add(a,b)
   #define param_mul(a,b) q31mul(a,b)
   #ifdef USE_FASTSINQ
     #define osc_sin(a) osc_fastsinq(a)
+    #define osc_wave(a,w,m) osc_fastsinq(a)
   #else
     #define osc_sin(a) osc_sinq(a)
+    #define osc_wave(a,w,m) osc_wavq(a,w,m)
   #endif
   #ifdef USE_Q31_PHASE
     typedef q31_t phase_t;
@@ -72,9 +79,12 @@
   typedef float pitch_t;
   #define f32_to_param(a) (a)
   #define param_to_q31(a) f32_to_q31(a)
+  #define param_to_f32(a) (a)
+  #define q31_to_param(a) q31_to_f32(a)
   #define param_add(a,b) ((a)+(b))
   #define param_mul(a,b) ((a)*(b))
   #define osc_sin(a) osc_sinf(a)
+  #define osc_wave(a,w,m) osc_sinf(a)
   #define phase_to_param(a) (a)
   #define f32_to_pitch(a) (a)
   #define pitch_to_phase(a) (a)
@@ -87,11 +97,12 @@
 //  #define DX7_DACAY_RATE_FACTOR -.125f
 #endif
 
-#define DX7_RATE_EXP_FACTOR .16f
-#define DX11_RATE_EXP_FACTOR .505f
-#define DX11_RELEASE_RATE_EXP_FACTOR 1.04f
-#define DX7_ATTACK_RATE_FACTOR 5.0200803e-7f // 1/(41.5*48000)
-#define DX7_DACAY_RATE_FACTOR -8.3668005e-8f // -1/(6*41.5*48000)
+//EG rate exponents are Q31 scaled by 1/32, see exp2q.h
+#define DX7_RATE_EXP_FACTOR 0x00A3D70A // .16/32
+#define DX11_RATE_EXP_FACTOR 0x02051EB8 // .505/32
+#define DX11_RELEASE_RATE_EXP_FACTOR 0x0428F5C3 // 1.04/32
+#define DX7_ATTACK_RATE_FACTOR -0x53B4014E // log2(1/(41.5*48000))/32
+#define DX7_DACAY_RATE_FACTOR -0x5E0B01B7 // log2(1/(6*41.5*48000))/32, negative rate
 
 #define DX7_MAX_RATE 99
 #define DX11_MAX_RATE 31
@@ -104,272 +115,763 @@
 
 #define FREQ_FACTOR .08860606f // (9.772 - 1)/99
 
+#define PEG_LEVEL_SCALE_RECIP .02f // 1/50
+#define PEG_RATE_FACTOR -0x4FB4014A // log2(2/(41.5*48000))/32, full PEG range takes as long as full EG range
+#define DX7_PEG_RANGE 4.f //octaves
+#define DX11_PEG_RANGE 1.f //octaves
+
+#define EG_CONTROL_RATE 16 //samples per EG update, operator gain is linearly ramped in between
+#define EG_CONTROL_RATE_LOW 32 //samples per EG update from governor level 1
+#define VOICE_CACHE_SIZE 4 //compiled voice records kept for quick voice switching
+#define MAX_POLY 4 //voice pool size
+//6-operator voices within the CPU budget: the heaviest algorithm takes about 16% of NTS-1
+//and 35% of prologue/minilogue xd cycles per sample, see host-bench. 4-operator voices take 2/3 of it.
+#define POLY_BUDGET_NTS1 3
+#define POLY_BUDGET_LOGUE 1
+#define GOVERNOR_LEVELS MAX_POLY //level 1 lowers EG control rate, each next one drops a voice
+
+enum {
+  perf_eg,
+  perf_ops,
+  perf_mix,
+};
+
 //static const dx7_voice_t *voice;
-static uint32_t s_bank = -1;
-static uint32_t s_voice = -1;
+static uint32_t s_bank = 0;
+static uint32_t s_voice = 0;
 static uint8_t s_algorithm_idx = -1;
 static uint8_t s_level_scale = -1;
-static const uint8_t *s_algorithm;
-static uint8_t s_opi;
-static uint8_t s_fixedfreq[DX7_OPERATOR_COUNT];
-static uint8_t s_egstage[DX7_OPERATOR_COUNT];
-static uint8_t s_transpose;
-static uint8_t s_feedback_src;
-//static uint8_t s_pegstage;
-//static uint8_t s_waveform[DX7_OPERATOR_COUNT];
 
 static uint8_t s_assignable[2] = {p_op6_level, p_op5_level};
 static param_t s_params[p_num];
-static param_t s_egrate[DX7_OPERATOR_COUNT][EG_STAGE_COUNT];
-static param_t s_eglevel[DX7_OPERATOR_COUNT][EG_STAGE_COUNT];
-static param_t s_egval[DX7_OPERATOR_COUNT];
-static param_t s_opval[DX7_OPERATOR_COUNT];
-static param_t s_feedback_opval[2];
+
 /*
-static param_t s_pegrate[EG_STAGE_COUNT];
-static param_t s_peglevel[EG_STAGE_COUNT];
-static param_t s_pegval[DX7_OPERATOR_COUNT];
-*/
+ * TX81Z waveforms as half period tables with osc_sinq resolution.
+ * The second half is either the negated first half (W1, W2) or silence (W3-W8).
+ */
+#define WAVEFORM_COUNT 8
+
+static q31_t s_wave_lut_q[WAVEFORM_COUNT][k_wt_sine_lut_size];
+static const q31_t s_wave_mask[WAVEFORM_COUNT] = {-1, -1, 0, 0, 0, 0, 0, 0};
+
+#ifdef OSC_SIN_Q
+static inline __attribute__((optimize("Ofast"), always_inline))
+q31_t osc_wavq(q31_t x, const q31_t *wt, q31_t mask) {
+  x &= 0x7FFFFFFF;
+  uint32_t x0p = x >> (31 - k_wt_sine_size_exp - 1);
+  const uint32_t x0 = x0p & k_wt_sine_mask;
+  const q31_t fr = (x << (k_wt_sine_size_exp + 1)) & 0x7FFFFFFF;
+  const q31_t y0 = linintq(fr, wt[x0], wt[x0 + 1]);
+  return (x0p < k_wt_sine_size) ? y0 : (-y0 & mask);
+}
 
-static pitch_t s_oppitch[DX7_OPERATOR_COUNT];
-static phase_t s_phase[DX7_OPERATOR_COUNT];
+//derived from the sine LUT, so W1 is identical to osc_sinq
+static void wave_initq() {
+  q31_t s, s2;
+  for (uint32_t i = k_wt_sine_size; i--;) {
+    s = wt_sine_lut_q[i]; //sin(pi*t)
+    s2 = i < k_wt_sine_size / 2 ? wt_sine_lut_q[i * 2] : -wt_sine_lut_q[i * 2 - k_wt_sine_size]; //sin(2*pi*t)
+    s_wave_lut_q[0][i] = s;
+    s_wave_lut_q[1][i] = q31mul(s, s);
+    s_wave_lut_q[2][i] = s;
+    s_wave_lut_q[3][i] = q31mul(s, s);
+    s_wave_lut_q[4][i] = s2;
+    s_wave_lut_q[5][i] = q31mul(s2, q31abs(s2));
+    s_wave_lut_q[6][i] = q31abs(s2);
+    s_wave_lut_q[7][i] = q31mul(s2, s2);
+  }
+  for (uint32_t w = WAVEFORM_COUNT; w--;)
+    s_wave_lut_q[w][k_wt_sine_size] = s_wave_lut_q[w][0];
+}
+#endif
+
+/*
+ * Voice record: everything derived from a dx_voices entry, compiled once
+ * so a voice change is a plain copy without any powf or float setup math.
+ */
+typedef struct {
+  uint8_t bank;
+  uint8_t voice;
+  uint8_t algorithm_idx;
+  uint8_t opi;
+  uint8_t transpose;
+  uint8_t fixedfreq[DX7_OPERATOR_COUNT];
+  uint8_t waveform[DX7_OPERATOR_COUNT];
+  param_t feedback;
+  param_t level[DX7_OPERATOR_COUNT];
+  param_t egrate[DX7_OPERATOR_COUNT][EG_STAGE_COUNT];
+  param_t eglevel[DX7_OPERATOR_COUNT][EG_STAGE_COUNT];
+  pitch_t oppitch[DX7_OPERATOR_COUNT];
+  param_t pegrate[EG_STAGE_COUNT];
+  param_t peglevel[EG_STAGE_COUNT];
+  float pegrange;
+} voice_rec_t;
+
+static voice_rec_t s_voicerec; //current voice
+static voice_rec_t s_voicecache[VOICE_CACHE_SIZE];
+static uint32_t s_voicecache_used[VOICE_CACHE_SIZE]; //LRU stamps, 0 = empty
+static uint32_t s_voicecache_stamp;
+
+/*
+ * Operator state used by the render loop, packed per operator in evaluation order (op6 first).
+ * Stage rate/level tables and pitch stay in the voice record, the current stage is cached here.
+ */
+typedef struct {
+  phase_t phase;
+  phase_t w0;
+  param_t gain; //EG value * output level, ramped within the EG control block
+  param_t gainstep;
+  param_t val; //last output, some algorithms modulate by the previous sample
+  param_t egval;
+  param_t egrate; //current stage rate
+  param_t eglevel; //current stage target level
+} __attribute__((aligned(32))) op_t;
+
+/*
+ * Voice pool: note state only, all voices share the compiled voice record.
+ */
+typedef struct {
+  op_t op[DX7_OPERATOR_COUNT];
+  param_t feedback_opval[2];
+  param_t pegval;
+  uint32_t stamp; //note on order, 0 = free
+  uint16_t pitch; //note on pitch
+  uint8_t egstage[DX7_OPERATOR_COUNT];
+  uint8_t pegstage;
+} poly_voice_t;
+
+static poly_voice_t s_poly[MAX_POLY];
+static poly_voice_t *s_pv = s_poly; //voice being processed
+static uint32_t s_poly_stamp;
+static uint32_t s_max_poly = 1;
+static uint32_t s_poly_limit = 1; //s_max_poly within the CPU budget for the current kernel
+static uint32_t s_poly_budget = POLY_BUDGET_NTS1 * DX7_OPERATOR_COUNT;
+static q31_t s_poly_gain;
+//mix level by polyphony, 1/sqrt(n)
+static const q31_t s_poly_gain_lut[MAX_POLY] = {0x7FFFFFFF, 0x5A82799A, 0x49E69D16, 0x40000000};
+static uint16_t s_note_pitch;
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void eg_stage(uint32_t i, uint32_t stage) {
+  s_pv->egstage[i] = stage;
+  s_pv->op[i].egrate = s_voicerec.egrate[i][stage];
+  s_pv->op[i].eglevel = s_voicerec.eglevel[i][stage];
+}
 
-void initvoice() {
-  if (dx_voices[s_bank][s_voice].dx7.vnam[0]) {
-    const dx7_voice_t *voice = &dx_voices[s_bank][s_voice].dx7;
-    s_opi = voice->opi;
-    s_algorithm_idx = voice->als;
-    s_algorithm = dx7_algorithm[s_algorithm_idx];
-    s_transpose = voice->trnp - TRANSPOSE_CENTER;
-
-    s_params[p_feedback] = (0x80 >> (8 - voice->fbl)) * FEEDBACK_RECIP;
-    s_feedback_opval[0] = ZERO;
-    s_feedback_opval[1] = ZERO;
 /*
+ * Control-rate EG: advances the envelope by a number of samples at once.
+ * Stage crossings are found at the exact sample they happen at, so the envelope
+ * timing does not depend on the control rate. The crossing sample is only divided
+ * out when the level is reached within the block, that is a libcall on Cortex-M4.
+ * Returns true when the stage level is reached, frames is reduced by the samples consumed.
+ */
+static inline __attribute__((optimize("Ofast"), always_inline))
+bool env_step(param_t &val, param_t rate, param_t level, uint32_t &frames) {
+  uint32_t n;
+  if (rate == ZERO)
+    return false;
 #ifdef USE_Q31
-//todo: PEG level precalc & Q31
+  const int64_t dist = (int64_t)level - val;
+  const int64_t span = (int64_t)rate * frames;
+  if ((rate > 0 && dist <= 0) || (rate < 0 && dist >= 0))
+    n = 1;
+  else if (rate > 0 ? span < dist : span > dist)
+    n = frames + 1;
+  else
+    n = (dist + (rate > 0 ? rate - 1 : rate + 1)) / rate;
 #else
-  float preveglevel = (float)(voice->pl[EG_STAGE_COUNT - 1] - PEG_CENTER) * PEG_SCALE;
-  for (uint32_t j = 0; j < EG_STAGE_COUNT; j++) {
-    s_pegrate[j] = k_samplerate_recipf * SCALE_RECIP * (s_peglevel[j] - prevlevel) / (RATE_FACTOR * (100 - voice->pr[j]));
-    prevlevel = voice->pl[j];
-    s_peglevel[j] = voice->pl[j];
+  const float dist = level - val;
+  const float span = rate * frames;
+  if ((rate > 0.f && dist <= 0.f) || (rate < 0.f && dist >= 0.f))
+    n = 1;
+  else if (rate > 0.f ? span < dist : span > dist)
+    n = frames + 1;
+  else
+    n = (uint32_t)ceilf(dist / rate);
 #endif
+  if (n > frames) {
+    val += rate * (int32_t)frames;
+    frames = 0;
+    return false;
   }
-*/
-    for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
-      s_fixedfreq[i] = voice->op[i].pm;
-//      s_waveform[i] = 0;
+  val = level;
+  frames -= n;
+  return true;
+}
 
-      s_phase[i] = ZERO_PHASE;
+static inline __attribute__((optimize("Ofast"), always_inline))
+param_t eg_advance(uint32_t i, uint32_t frames) {
+  param_t val = s_pv->op[i].egval;
+  while (frames && env_step(val, s_pv->op[i].egrate, s_pv->op[i].eglevel, frames) && s_pv->egstage[i] < EG_STAGE_COUNT - 2)
+    eg_stage(i, s_pv->egstage[i] + 1);
+  return val;
+}
+
+/*
+ * PEG: the pitch offset is applied to ratio operator increments once per control block
+ */
+static inline __attribute__((optimize("Ofast"), always_inline))
+void peg_control(float basew0, uint32_t frames) {
+  pitch_t w0 = f32_to_pitch(s_pv->pegval == ZERO ? basew0 : basew0 * fastpow2f(param_to_f32(s_pv->pegval) * s_voicerec.pegrange));
+  for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
+    if (!s_voicerec.fixedfreq[i])
+      s_pv->op[i].w0 = pitch_to_phase(pitch_mul(s_voicerec.oppitch[i], w0));
+  }
+  while (frames && env_step(s_pv->pegval, s_voicerec.pegrate[s_pv->pegstage], s_voicerec.peglevel[s_pv->pegstage], frames) && s_pv->pegstage < EG_STAGE_COUNT - 2)
+    s_pv->pegstage++;
+}
+
+//rate = factor * 2^(exp * r), evaluated as 2^(log2(factor) + exp * r) with wrap-safe unsigned sum
+static inline __attribute__((optimize("Ofast"), always_inline))
+param_t eg_rate(q31_t log2factor, q31_t exp, uint32_t r) {
+  return q31_to_param(pow2q((q31_t)((uint32_t)log2factor + (uint32_t)exp * r)));
+}
+
+//PEG levels are centered, the previous stage level is the starting point like with the EG
+static void peg_init(voice_rec_t *rec, const uint8_t *pr, const uint8_t *pl, float range) {
+  int32_t dl;
+  rec->pegrange = range;
+  for (uint32_t j = EG_STAGE_COUNT; j--;) {
+    dl = pl[j] - pl[j ? (j - 1) : EG_STAGE_COUNT - 1];
+    rec->peglevel[j] = f32_to_param((pl[j] - PEG_CENTER) * PEG_LEVEL_SCALE_RECIP);
+//flat stage is passed immediately rather than held, sustain is held at the stage level anyway
+    rec->pegrate[j] = eg_rate(PEG_RATE_FACTOR, DX7_RATE_EXP_FACTOR, pr[j]);
+    if (dl < 0)
+      rec->pegrate[j] = -rec->pegrate[j];
+  }
+}
+
+//returns true when all operators are released to silence, so the voice can be freed
+static inline __attribute__((optimize("Ofast"), always_inline))
+bool eg_control(uint32_t frames) {
+  bool done = true;
+  for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
+    s_pv->op[i].gain = param_mul(s_pv->op[i].egval, s_params[p_op6_level + i * 10]);
+    s_pv->op[i].egval = eg_advance(i, frames);
+    s_pv->op[i].gainstep = (param_mul(s_pv->op[i].egval, s_params[p_op6_level + i * 10]) - s_pv->op[i].gain) / (int32_t)frames;
+    done &= s_pv->egstage[i] == EG_STAGE_COUNT - 1 && s_pv->op[i].egval == ZERO;
+  }
+  return done;
+}
+
+/*
+ * Algorithm routing: each dx7_algorithm row is resolved once per algorithm change
+ * into modulator bit masks, so a single block loop serves all the algorithms.
+ * Operators only modulate operators evaluated after them, so each operator is
+ * rendered across the whole block into a scratch buffer before the next one.
+ * The feedback loop (feedback operator through feedback source) is the only
+ * part that is still interleaved per sample.
+ */
+static constexpr uint8_t feedback_src(uint8_t mods) {
+  return mods > 1 ? 1 + feedback_src(mods >> 1) : 0;
+}
+
+static constexpr uint8_t feedback_op(uint8_t alg, uint8_t i = 0) {
+  return (dx7_algorithm[alg][i] & ALG_FBK_MASK) || i == DX7_OPERATOR_COUNT - 1 ? i : feedback_op(alg, i + 1);
+}
+
+static constexpr uint8_t feedback_src_op(uint8_t alg) {
+  return feedback_src(dx7_algorithm[alg][feedback_op(alg)] & (ALG_FBK_MASK - 1));
+}
+
+typedef struct {
+  uint8_t mods[DX7_OPERATOR_COUNT]; //modulators of each operator, own bit excluded
+  uint8_t self; //operators modulated by their own previous sample
+  uint8_t out; //carriers
+  uint8_t fbop; //feedback loop operators
+  uint8_t fbsrc;
+} alg_t;
+
+static alg_t s_alg;
+
+static void alg_init(alg_t *alg, uint8_t idx) {
+  alg->self = 0;
+  alg->out = 0;
+  alg->fbop = feedback_op(idx);
+  alg->fbsrc = feedback_src_op(idx);
+  for (uint32_t i = 0; i < DX7_OPERATOR_COUNT; i++) {
+    const uint8_t mask = dx7_algorithm[idx][i];
+    alg->mods[i] = mask & ALG_FBK_MASK ? 0 : mask & (ALG_FBK_MASK - 1) & ~(1 << i);
+    if (!(mask & ALG_FBK_MASK) && (mask & (1 << i)))
+      alg->self |= 1 << i;
+    if (mask & ALG_OUT_MASK)
+      alg->out |= 1 << i;
+  }
+}
+
+//modulation of an operator: the current sample of the preceding operators, the previous one of the following ones
+static inline __attribute__((optimize("Ofast"), always_inline))
+bool opcycle_mod(param_t *mod, const param_t (*buf)[EG_CONTROL_RATE_LOW], uint32_t i, uint32_t frames) {
+  uint32_t mods = s_alg.mods[i];
+  param_t bias = ZERO;
+  bool first = true;
+  if (!mods)
+    return false;
+  for (; mods; mods &= mods - 1) {
+    const uint32_t k = __builtin_ctz(mods);
+    if (k > i) {
+      bias += s_pv->op[k].val;
+    } else if (first) {
+      first = false;
+      for (uint32_t f = 0; f < frames; f++)
+        mod[f] = buf[k][f];
+    } else {
+      for (uint32_t f = 0; f < frames; f++)
+        mod[f] += buf[k][f];
+    }
+  }
+  if (first) {
+    for (uint32_t f = 0; f < frames; f++)
+      mod[f] = bias;
+  } else if (bias != ZERO) {
+    for (uint32_t f = 0; f < frames; f++)
+      mod[f] += bias;
+  }
+  return true;
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void op_phase(op_t &op) {
+  op.phase += op.w0;
+#ifndef USE_Q31_PHASE
+  op.phase -= (uint32_t)(op.phase);
+#endif
+}
+
+//operator outside the feedback loop: whole block at once
+template<bool modulated, bool self>
+static inline __attribute__((optimize("Ofast"), always_inline))
+void opcycle_block(op_t &op, const q31_t *wt, q31_t wm, const param_t *mod, param_t *out, uint32_t frames) {
+  param_t val = op.val;
+  for (uint32_t f = 0; f < frames; f++) {
+    param_t modw0 = phase_to_param(op.phase);
+    if (modulated) modw0 += mod[f];
+    if (self) modw0 += val;
+//todo: modindex[egval*out_level] ?
+    out[f] = val = param_mul(osc_wave(modw0, wt, wm), op.gain);
+    op.gain += op.gainstep;
+    op_phase(op);
+  }
+  op.val = val;
+}
+
+//single operator feedback loop, the most of the algorithms have it
+static inline __attribute__((optimize("Ofast"), always_inline))
+void opcycle_feedback(op_t &op, const q31_t *wt, q31_t wm, param_t *out, uint32_t frames) {
+  param_t fb0 = s_pv->feedback_opval[0], fb1 = s_pv->feedback_opval[1];
+  const param_t feedback = s_params[p_feedback];
+  for (uint32_t f = 0; f < frames; f++) {
+    const param_t modw0 = phase_to_param(op.phase) + param_mul(fb0, feedback) + param_mul(fb1, feedback);
+    fb1 = fb0;
+    out[f] = fb0 = param_mul(osc_wave(modw0, wt, wm), op.gain);
+    op.gain += op.gainstep;
+    op_phase(op);
+  }
+  op.val = fb0;
+  s_pv->feedback_opval[0] = fb0;
+  s_pv->feedback_opval[1] = fb1;
+}
+
+//multiple operator feedback loop: one sample of each loop operator at a time
+static inline __attribute__((optimize("Ofast"), always_inline))
+void opcycle_feedback_loop(param_t (*buf)[EG_CONTROL_RATE_LOW], uint32_t fbsrc, uint32_t frames) {
+  const param_t feedback = s_params[p_feedback];
+  const uint32_t fbop = s_alg.fbop;
+  for (uint32_t f = 0; f < frames; f++) {
+    for (uint32_t i = fbop; i <= fbsrc; i++) {
+      op_t &op = s_pv->op[i];
+      param_t modw0 = phase_to_param(op.phase);
+      if (i == fbop) {
+        modw0 += param_mul(s_pv->feedback_opval[0], feedback);
+        modw0 += param_mul(s_pv->feedback_opval[1], feedback);
+      } else {
+        for (uint32_t mods = s_alg.mods[i]; mods; mods &= mods - 1) {
+          const uint32_t k = __builtin_ctz(mods);
+          modw0 += k < i ? buf[k][f] : s_pv->op[k].val;
+        }
+        if (s_alg.self & (1 << i))
+          modw0 += op.val;
+      }
+      const param_t val = param_mul(osc_wave(modw0, s_wave_lut_q[s_voicerec.waveform[i]], s_wave_mask[s_voicerec.waveform[i]]), op.gain);
+      if (i == fbsrc) {
+        s_pv->feedback_opval[1] = s_pv->feedback_opval[0];
+        s_pv->feedback_opval[0] = val;
+      }
+      buf[i][f] = op.val = val;
+      op.gain += op.gainstep;
+      op_phase(op);
+    }
+  }
+}
+
+/*
+ * Only the operator count is specialized at compile time.
+ * opcount 4 is the fast path for DX11 voices and silent op2/op1: they are only
+ * able to modulate each other, so with zero output level they are skipped and
+ * just keep their phase running.
+ */
+template<uint8_t opcount>
+static void opcycle(q31_t * __restrict y, uint32_t frames) {
+  param_t buf[DX7_OPERATOR_COUNT][EG_CONTROL_RATE_LOW];
+  param_t mod[EG_CONTROL_RATE_LOW];
+  const uint32_t fbop = s_alg.fbop;
+  const uint32_t fbsrc = s_alg.fbsrc;
+  for (uint32_t i = 0; i < opcount; i++) {
+    if (i == fbop && fbsrc > fbop) {
+      opcycle_feedback_loop(buf, fbsrc, frames);
+      continue;
+    }
+    if (i > fbop && i <= fbsrc)
+      continue;
+    op_t op = s_pv->op[i];
+    const q31_t *wt = s_wave_lut_q[s_voicerec.waveform[i]];
+    const q31_t wm = s_wave_mask[s_voicerec.waveform[i]];
+    if (i == fbop) {
+      opcycle_feedback(op, wt, wm, buf[i], frames);
+    } else {
+      const bool modulated = opcycle_mod(mod, buf, i, frames);
+      if (s_alg.self & (1 << i)) {
+        if (modulated)
+          opcycle_block<true, true>(op, wt, wm, mod, buf[i], frames);
+        else
+          opcycle_block<false, true>(op, wt, wm, mod, buf[i], frames);
+      } else {
+        if (modulated)
+          opcycle_block<true, false>(op, wt, wm, mod, buf[i], frames);
+        else
+          opcycle_block<false, false>(op, wt, wm, mod, buf[i], frames);
+      }
+    }
+    s_pv->op[i] = op;
+  }
+//carriers are accumulated into the output in evaluation order
+  for (uint32_t f = 0; f < frames; f++)
+    y[f] = ZERO;
+  for (uint32_t i = 0; i < opcount; i++) {
+    if (s_alg.out & (1 << i))
+      for (uint32_t f = 0; f < frames; f++)
+        y[f] = param_add(y[f], buf[i][f]);
+  }
+  for (uint32_t i = opcount; i < DX7_OPERATOR_COUNT; i++) {
+    s_pv->op[i].val = ZERO;
+#ifdef USE_Q31_PHASE
+    s_pv->op[i].phase += (q31_t)((uint32_t)s_pv->op[i].w0 * frames);
+#else
+    s_pv->op[i].phase += s_pv->op[i].w0 * frames;
+    s_pv->op[i].phase -= (uint32_t)(s_pv->op[i].phase);
+#endif
+  }
+}
+
+typedef void (*opcycle_t)(q31_t * __restrict y, uint32_t frames);
+
+static const opcycle_t opcycle_lut[2] = {
+  opcycle<DX7_OPERATOR_COUNT>,
+  opcycle<DX11_OPERATOR_COUNT>
+};
+
+static opcycle_t s_opcycle = opcycle_lut[0];
+
+static uint32_t poly_oldest() {
+  uint32_t oldest = 0;
+  for (uint32_t k = MAX_POLY; k--;) {
+    if (s_poly[k].stamp && (!s_poly[oldest].stamp || s_poly[k].stamp < s_poly[oldest].stamp))
+      oldest = k;
+  }
+  return oldest;
+}
+
+//the oldest voices are dropped rather than rendered over the CPU budget
+static void poly_drop(uint32_t limit) {
+  uint32_t count = 0;
+  for (uint32_t k = MAX_POLY; k--;) {
+    if (s_poly[k].stamp)
+      count++;
+  }
+  for (; count > limit; count--)
+    s_poly[poly_oldest()].stamp = 0;
+}
+
+//voices left by the governor, each level from 2 on drops one
+static inline __attribute__((optimize("Ofast"), always_inline))
+uint32_t poly_governed() {
+  const uint32_t level = governor_level();
+  return level > 1 ? (s_poly_limit > level - 1 ? s_poly_limit - (level - 1) : 1) : s_poly_limit;
+}
+
+static inline __attribute__((optimize("Ofast"), always_inline))
+void setopcycle() {
+  const bool op4 = s_params[p_op2_level] == ZERO && s_params[p_op1_level] == ZERO;
+  s_opcycle = opcycle_lut[op4];
+  alg_init(&s_alg, s_algorithm_idx);
+  s_poly_limit = s_poly_budget / (op4 ? DX11_OPERATOR_COUNT : DX7_OPERATOR_COUNT);
+  if (s_poly_limit > s_max_poly)
+    s_poly_limit = s_max_poly;
+  poly_drop(s_poly_limit);
+}
+
+static void compilevoice(voice_rec_t *rec, uint32_t bank, uint32_t voice_idx) {
+  *rec = voice_rec_t();
+  rec->bank = bank;
+  rec->voice = voice_idx;
+  if (dx_voices[bank][voice_idx].dx7.vnam[0]) {
+    const dx7_voice_t *voice = &dx_voices[bank][voice_idx].dx7;
+    rec->opi = voice->opi;
+    rec->algorithm_idx = voice->als;
+    rec->transpose = voice->trnp - TRANSPOSE_CENTER;
+
+    rec->feedback = (0x80 >> (8 - voice->fbl)) * FEEDBACK_RECIP;
+    peg_init(rec, voice->pr, voice->pl, DX7_PEG_RANGE);
+    for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
+      rec->fixedfreq[i] = voice->op[i].pm;
+      rec->waveform[i] = 0;
 
 //todo: check dx7 D1/D2/R rates
       int32_t dl;
       for (uint32_t j = EG_STAGE_COUNT; j--;) {
         dl = voice->op[i].l[j] - voice->op[i].l[j ? (j - 1) : EG_STAGE_COUNT - 1];
         if (dl > 0)
-          s_egrate[i][j] = f32_to_param(DX7_ATTACK_RATE_FACTOR * powf(2.f, DX7_RATE_EXP_FACTOR * voice->op[i].r[j]));
+          rec->egrate[i][j] = eg_rate(DX7_ATTACK_RATE_FACTOR, DX7_RATE_EXP_FACTOR, voice->op[i].r[j]);
         else if (dl < 0)
-          s_egrate[i][j] = f32_to_param(DX7_DACAY_RATE_FACTOR * powf(2.f, DX7_RATE_EXP_FACTOR * voice->op[i].r[j]));
+          rec->egrate[i][j] = -eg_rate(DX7_DACAY_RATE_FACTOR, DX7_RATE_EXP_FACTOR, voice->op[i].r[j]);
         else 
-          s_egrate[i][j] = ZERO;
-        s_eglevel[i][j] = f32_to_param(voice->op[i].l[j] * DX7_EG_LEVEL_SCALE_RECIP);
+          rec->egrate[i][j] = ZERO;
+        rec->eglevel[i][j] = f32_to_param(voice->op[i].l[j] * DX7_EG_LEVEL_SCALE_RECIP);
       }
-      s_opval[i] = ZERO;
-      s_egstage[i] = 0;
-      s_egval[i] = s_eglevel[i][EG_STAGE_COUNT - 1];
 
-      if (s_fixedfreq[i])
-        s_oppitch[i] = f32_to_pitch(((voice->op[i].pc == 0 ? 1.f : voice->op[i].pc == 1 ? 10.f : voice->op[i].pc == 2 ? 100.f : 1000.f) * (1.f + voice->op[i].pf * FREQ_FACTOR)) * k_samplerate_recipf);
+      if (rec->fixedfreq[i])
+        rec->oppitch[i] = f32_to_pitch(((voice->op[i].pc == 0 ? 1.f : voice->op[i].pc == 1 ? 10.f : voice->op[i].pc == 2 ? 100.f : 1000.f) * (1.f + voice->op[i].pf * FREQ_FACTOR)) * k_samplerate_recipf);
       else
-        s_oppitch[i] = f32_to_pitch(((voice->op[i].pc == 0 ? .5f : voice->op[i].pc) * (1.f + voice->op[i].pf * .01f)));
+        rec->oppitch[i] = f32_to_pitch(((voice->op[i].pc == 0 ? .5f : voice->op[i].pc) * (1.f + voice->op[i].pf * .01f)));
     }
-    s_params[p_op6_level] = voice->op[0].tl * SCALE_RECIP;
-    s_params[p_op5_level] = voice->op[1].tl * SCALE_RECIP;
-    s_params[p_op4_level] = voice->op[2].tl * SCALE_RECIP;
-    s_params[p_op3_level] = voice->op[3].tl * SCALE_RECIP;
-    s_params[p_op2_level] = voice->op[4].tl * SCALE_RECIP;
-    s_params[p_op1_level] = voice->op[5].tl * SCALE_RECIP;
+    rec->level[0] = voice->op[0].tl * SCALE_RECIP;
+    rec->level[1] = voice->op[1].tl * SCALE_RECIP;
+    rec->level[2] = voice->op[2].tl * SCALE_RECIP;
+    rec->level[3] = voice->op[3].tl * SCALE_RECIP;
+    rec->level[4] = voice->op[4].tl * SCALE_RECIP;
+    rec->level[5] = voice->op[5].tl * SCALE_RECIP;
   } else {
-    const dx11_voice_t *voice = &dx_voices[s_bank][s_voice].dx11;
-    s_algorithm_idx = dx11_algorithm_lut[voice->alg];
-    s_algorithm = dx7_algorithm[s_algorithm_idx];
-    s_opi = 0;
-    s_transpose = voice->trps - TRANSPOSE_CENTER;
+    const dx11_voice_t *voice = &dx_voices[bank][voice_idx].dx11;
+    rec->algorithm_idx = dx11_algorithm_lut[voice->alg];
+    rec->opi = 0;
+    rec->transpose = voice->trps - TRANSPOSE_CENTER;
 
-    s_params[p_feedback] = (0x80 >> (8 - voice->fbl)) * FEEDBACK_RECIP;
+    rec->feedback = (0x80 >> (8 - voice->fbl)) * FEEDBACK_RECIP;
+//3-stage PEG mapped onto attack, decay, sustain hold and release
+    const uint8_t pr[EG_STAGE_COUNT] = {voice->pr[0], voice->pr[1], voice->pr[1], voice->pr[2]};
+    const uint8_t pl[EG_STAGE_COUNT] = {voice->pl[0], voice->pl[1], voice->pl[1], voice->pl[2]};
+    peg_init(rec, pr, pl, DX11_PEG_RANGE);
 
     for (uint32_t k = DX11_OPERATOR_COUNT; k--;) {
       uint32_t i;
-      if (s_algorithm_idx == 7)
+      if (rec->algorithm_idx == 7)
         i = dx11_alg3_op_lut[k];
       else
         i = k;
 
-      s_fixedfreq[i] = voice->opadd[i].fixrg;
-//      s_waveform[i] =  voice->opadd[i].osw;
-
-      s_phase[i] = ZERO_PHASE;
+      rec->fixedfreq[i] = voice->opadd[i].fixrg;
+      rec->waveform[i] = voice->opadd[i].osw;
 
 //todo: check dx11 rates
       int32_t dl;
       for (uint32_t j = 0; j < EG_STAGE_COUNT; j++) {
-        if (j == (EG_STAGE_COUNT - 2) && s_egrate[i][j] == 0)
+        if (j == (EG_STAGE_COUNT - 2) && voice->op[i].r[j] == 0) //D2R 0 holds D1L
           dl = 0;
         else
           dl = (j==0 ? DX11_MAX_LEVEL : j == 1 ? voice->op[i].d1l - DX11_MAX_LEVEL : - voice->op[i].d1l);
         if (dl > 0)
-          s_egrate[i][j] = f32_to_param(DX7_ATTACK_RATE_FACTOR * powf(2.f, DX11_RATE_EXP_FACTOR * (voice->op[i].r[j] + (voice->op[i].r[j] == 0 && j == (EG_STAGE_COUNT - 1) ? 0 : 1))));
+          rec->egrate[i][j] = eg_rate(DX7_ATTACK_RATE_FACTOR, DX11_RATE_EXP_FACTOR, voice->op[i].r[j] + (voice->op[i].r[j] == 0 && j == (EG_STAGE_COUNT - 1) ? 0 : 1));
         else if (dl < 0)
-          s_egrate[i][j] = f32_to_param(DX7_DACAY_RATE_FACTOR * powf(2.f, (j == (EG_STAGE_COUNT - 1) ? DX11_RELEASE_RATE_EXP_FACTOR : DX11_RATE_EXP_FACTOR) * (voice->op[i].r[j] + (voice->op[i].r[j] == 0 && j == (EG_STAGE_COUNT - 1) ? 0 : 1))));
+          rec->egrate[i][j] = -eg_rate(DX7_DACAY_RATE_FACTOR, j == (EG_STAGE_COUNT - 1) ? DX11_RELEASE_RATE_EXP_FACTOR : DX11_RATE_EXP_FACTOR, voice->op[i].r[j] + (voice->op[i].r[j] == 0 && j == (EG_STAGE_COUNT - 1) ? 0 : 1));
         else 
-          s_egrate[i][j] = ZERO;
-        s_eglevel[i][j] = f32_to_param(1.f - (1.f - (j==0 ? 1.f : j == 1 ? voice->op[i].d1l * DX11_EG_LEVEL_SCALE_RECIP : 0.f)) / (1 << (i != 3 ? voice->opadd[i].egsft : 0)));
+          rec->egrate[i][j] = ZERO;
+        rec->eglevel[i][j] = f32_to_param(1.f - (1.f - (j==0 ? 1.f : j == 1 ? voice->op[i].d1l * DX11_EG_LEVEL_SCALE_RECIP : 0.f)) / (1 << (i != 3 ? voice->opadd[i].egsft : 0)));
       }
-      s_opval[i] = ZERO;
-      s_egstage[i] = 0;
-      s_egval[i] = s_eglevel[i][EG_STAGE_COUNT - 1];
 
 //todo: Fine freq ratio
-      if (s_fixedfreq[i])
-        s_oppitch[i] = f32_to_pitch(((((voice->op[i].f & 0x3C) << 2) + voice->opadd[i].fine + (voice->op[i].f < 4 ? 8 : 0)) << voice->opadd[i].fixrg) * k_samplerate_recipf);
+      if (rec->fixedfreq[i])
+        rec->oppitch[i] = f32_to_pitch(((((voice->op[i].f & 0x3C) << 2) + voice->opadd[i].fine + (voice->op[i].f < 4 ? 8 : 0)) << voice->opadd[i].fixrg) * k_samplerate_recipf);
       else
-        s_oppitch[i] = f32_to_pitch(dx11_ratio_lut[voice->op[i].f]);
-//todo: Waveform
-//if (s_waveform[i] & 0x01)
-//  s_oppitch[i] *= 2;
+        rec->oppitch[i] = f32_to_pitch(dx11_ratio_lut[voice->op[i].f]);
     }
-    s_params[p_op6_level] = voice->op[0].out * SCALE_RECIP;
-    s_params[p_op5_level] = voice->op[1].out * SCALE_RECIP;
-    s_params[p_op4_level] = voice->op[2].out * SCALE_RECIP;
-    s_params[p_op3_level] = voice->op[3].out * SCALE_RECIP;
-    s_params[p_op2_level] = ZERO;
-    s_params[p_op1_level] = ZERO;
-    s_opval[4] = ZERO;
-    s_opval[5] = ZERO;
+    rec->level[0] = voice->op[0].out * SCALE_RECIP;
+    rec->level[1] = voice->op[1].out * SCALE_RECIP;
+    rec->level[2] = voice->op[2].out * SCALE_RECIP;
+    rec->level[3] = voice->op[3].out * SCALE_RECIP;
+  }
+}
+
+static const voice_rec_t *cachevoice(uint32_t bank, uint32_t voice) {
+  uint32_t k, lru = 0;
+  for (k = 0; k < VOICE_CACHE_SIZE; k++) {
+    if (s_voicecache_used[k] && s_voicecache[k].bank == bank && s_voicecache[k].voice == voice)
+      break;
+    if (s_voicecache_used[k] < s_voicecache_used[lru])
+      lru = k;
   }
+  if (k == VOICE_CACHE_SIZE)
+    compilevoice(&s_voicecache[k = lru], bank, voice);
+  s_voicecache_used[k] = ++s_voicecache_stamp;
+  return &s_voicecache[k];
+}
 
+void initvoice() {
+  s_voicerec = *cachevoice(s_bank, s_voice);
+  s_algorithm_idx = s_voicerec.algorithm_idx;
+  s_params[p_feedback] = s_voicerec.feedback;
+  for (uint32_t i = DX7_OPERATOR_COUNT; i--;)
+    s_params[p_op6_level + i * 10] = s_voicerec.level[i];
+//held notes are dropped, the first voice starts over as a single note does
+  for (uint32_t k = MAX_POLY; k--;)
+    s_poly[k].stamp = 0;
+  s_pv = s_poly;
+  s_pv->stamp = ++s_poly_stamp;
+  s_pv->pitch = s_note_pitch;
+  setopcycle();
+  s_pv->feedback_opval[0] = ZERO;
+  s_pv->feedback_opval[1] = ZERO;
   for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
-    if (s_algorithm[i] & ALG_FBK_MASK) {
-      s_feedback_src = 0;
-      for (uint32_t j = (s_algorithm[i] & (ALG_FBK_MASK - 1)) >> 1; j; j >>= 1, s_feedback_src++);
-    }
+    s_pv->op[i].phase = ZERO_PHASE;
+    s_pv->op[i].val = ZERO;
+    s_pv->op[i].egval = s_voicerec.eglevel[i][EG_STAGE_COUNT - 1];
+    eg_stage(i, 0);
   }
+  s_pv->pegstage = 0;
+  s_pv->pegval = s_voicerec.peglevel[EG_STAGE_COUNT - 1];
 }
 
-void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused)) uint32_t api)
+void OSC_INIT(uint32_t platform, __attribute__((unused)) uint32_t api)
 {
 #ifdef USE_Q31
   osc_api_initq();
 #endif
+#ifdef OSC_SIN_Q
+  wave_initq();
+#endif
+  exp2_initq();
+  governor_init(platform, GOVERNOR_LEVELS);
+  PERF_INIT("EG", "operators", "voice mix");
+  for (uint32_t k = VOICE_CACHE_SIZE; k--;)
+    s_voicecache_used[k] = 0;
+  s_poly_budget = ((platform & k_user_target_platform_mask) == k_user_target_nutektdigital ? POLY_BUDGET_NTS1 : POLY_BUDGET_LOGUE) * DX7_OPERATOR_COUNT;
+  s_max_poly = 1;
+  s_poly_gain = s_poly_gain_lut[0];
+  s_note_pitch = 0;
+  initvoice();
 }
 
 void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames)
 {
-//todo: PEG level
-  param_t osc_out, modw0;
-  phase_t opw0[DX7_OPERATOR_COUNT];
-  pitch_t basew0 = f32_to_pitch(osc_w0f_for_note((params->pitch >> 8) + s_transpose, params->pitch & 0xFF));
-
-  for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
-    if (s_fixedfreq[i])
-      opw0[i] = pitch_to_phase(s_oppitch[i]);
-    else
-      opw0[i] = pitch_to_phase(pitch_mul(s_oppitch[i], basew0));
+  float basew0[MAX_POLY];
+  PERF_BLOCK_BEGIN();
+  governor_start();
+  const uint32_t level = governor_level();
+  const uint32_t eg_control_rate = level ? EG_CONTROL_RATE_LOW : EG_CONTROL_RATE;
+  if (level > 1)
+    poly_drop(poly_governed());
+//pitch wheel applies to all the held notes
+  const int32_t bend = params->pitch - s_note_pitch;
+  for (uint32_t k = MAX_POLY; k--;) {
+    s_pv = &s_poly[k];
+    if (!s_pv->stamp)
+      continue;
+    int32_t pitch = s_pv->pitch + bend;
+    if (pitch < 0)
+      pitch = 0;
+    basew0[k] = osc_w0f_for_note((pitch >> 8) + s_voicerec.transpose, pitch & 0xFF);
+    for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
+      if (s_voicerec.fixedfreq[i])
+        s_pv->op[i].w0 = pitch_to_phase(s_voicerec.oppitch[i]);
+    }
   }
 
   q31_t * __restrict y = (q31_t *)yn;
-  for (uint32_t f = frames; f--; y++) {
-    osc_out = ZERO;
-    for (uint32_t i = 0; i < DX7_OPERATOR_COUNT; i++) {
-      modw0 = phase_to_param(s_phase[i]);
-      if (s_algorithm[i] & ALG_FBK_MASK) {
-        modw0 += param_mul(s_feedback_opval[0], s_params[p_feedback]);
-        modw0 += param_mul(s_feedback_opval[1], s_params[p_feedback]);
-      } else if (s_algorithm[i] & (ALG_FBK_MASK - 1)) {
-        if (s_algorithm[i] & ALG_MOD6_MASK) modw0 += s_opval[0];
-        if (s_algorithm[i] & ALG_MOD5_MASK) modw0 += s_opval[1];
-        if (s_algorithm[i] & ALG_MOD4_MASK) modw0 += s_opval[2];
-        if (s_algorithm[i] & ALG_MOD3_MASK) modw0 += s_opval[3];
-        if (s_algorithm[i] & ALG_MOD2_MASK) modw0 += s_opval[4];
-        if (s_algorithm[i] & ALG_MOD1_MASK) modw0 += s_opval[5];
+  q31_t voicebuf[EG_CONTROL_RATE_LOW];
+  for (uint32_t f = frames, n; f; f -= n, y += n) {
+    n = f < eg_control_rate ? f : eg_control_rate;
+//the first voice is rendered in place, the others are mixed in
+    q31_t *out = y;
+    for (uint32_t k = MAX_POLY; k--;) {
+      s_pv = &s_poly[k];
+      if (!s_pv->stamp)
+        continue;
+      {
+        PERF_SCOPE(perf_eg);
+        peg_control(basew0[k], n);
+        if (eg_control(n))
+          s_pv->stamp = 0;
       }
-
-      s_opval[i] = osc_sin(modw0);
-//todo: move output level to EG calculation
-      if (i == s_feedback_src) {
-        s_feedback_opval[1] = s_feedback_opval[0];
-        s_feedback_opval[0] = param_mul(s_opval[i], param_mul(s_egval[i], s_params[p_op6_level + i * 10]));
+      {
+        PERF_SCOPE(perf_ops);
+        s_opcycle(out, n);
       }
-//todo: modindex[egval*out_level] ?
-      s_opval[i] = param_mul(s_opval[i], param_mul(s_egval[i], s_params[p_op6_level + i * 10]));
-
-      if (s_algorithm[i] & ALG_OUT_MASK)
-        osc_out = param_add(osc_out, s_opval[i]);
-
-      s_phase[i] += opw0[i];
-#ifndef USE_Q31_PHASE
-      s_phase[i] -= (uint32_t)(s_phase[i]);
-#endif
-
-//todo: flatten the level/rate arrays and get rid of the excessive indexing
-      s_egval[i] = param_add(s_egval[i], s_egrate[i][s_egstage[i]]);
-      if (
-        (s_egrate[i][s_egstage[i]] > ZERO && (s_egval[i] >= s_eglevel[i][s_egstage[i]] || s_egval[i] < 0)) //fixed-point overflow check
-        || (s_egrate[i][s_egstage[i]] < ZERO && s_egval[i] <= s_eglevel[i][s_egstage[i]])
-      ) {
-        s_egval[i] = s_eglevel[i][s_egstage[i]];
-        if (s_egstage[i] < EG_STAGE_COUNT - 2)
-          s_egstage[i]++;
+      if (s_max_poly > 1) {
+        PERF_SCOPE(perf_mix);
+        if (out == y) {
+          for (uint32_t j = 0; j < n; j++)
+            y[j] = q31mul(y[j], s_poly_gain);
+        } else {
+          for (uint32_t j = 0; j < n; j++)
+            y[j] = q31add(y[j], q31mul(voicebuf[j], s_poly_gain));
+        }
       }
-
+      out = voicebuf;
     }
-/*
-//todo: PEG level
-#ifdef USE_Q31
-    s_pegval = q31add(s_pegval, s_pegrate[s_pegstage]);
-    if (
-      (s_pegrate[s_pegstage] > 0 && s_pegval >= s_pegrate[s_pegstage])
-      || (s_pegrate[s_pegstage] < 0 && s_pegval <= s_pegrate[s_pegstage])
-      || s_pegrate[s_pegstage] == 0
-    ) {
-#else
-    s_pegval += s_pegrate[s_pegstage];
-    if (
-      (s_pegrate[s_pegstage] > 0.f && s_pegval >= s_pegrate[s_pegstage])
-      || (s_pegrate[s_pegstage] < 0.f && s_pegval <= s_pegrate[s_pegstage])
-      || s_pegrate[s_pegstage] == 0.f
-    ) {
-#endif
-       s_pegval = s_peglevel[s_pegstage];
-       if (s_pegstage < 3)
-        s_pegstage++;
+    if (out == y) {
+      for (uint32_t j = 0; j < n; j++)
+        y[j] = 0;
     }
-*/
-    *y = param_to_q31(osc_out);
   }
+  governor_stop(frames);
+  PERF_BLOCK_END(frames);
 }
 
-void OSC_NOTEON(__attribute__((unused)) const user_osc_param_t * const params)
+void OSC_NOTEON(const user_osc_param_t * const params)
 {
+  uint32_t k, count = 0, v = MAX_POLY;
+  const uint32_t limit = poly_governed();
+  s_note_pitch = params->pitch;
+  for (k = MAX_POLY; k--;) {
+    if (s_poly[k].stamp) {
+      count++;
+      if (s_poly[k].pitch == params->pitch)
+        v = k;
+    }
+  }
+//repeated note retriggers its voice, otherwise a free one is taken or the oldest one is stolen,
+//the governor limit applies so the new note is not dropped on the next block
+  if (v == MAX_POLY) {
+    if (count < limit)
+      for (v = 0; s_poly[v].stamp; v++);
+    else
+      v = poly_oldest();
+  }
+  s_pv = &s_poly[v];
+  s_pv->stamp = ++s_poly_stamp;
+  s_pv->pitch = params->pitch;
   for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
-    if (s_opi)
-      s_phase[i] = ZERO_PHASE;
+    if (s_voicerec.opi)
+      s_pv->op[i].phase = ZERO_PHASE;
 //todo: to reset or not to reset - that is the question (stick with the operator phase init)
-    s_opval[i] = ZERO;
-    s_egstage[i] = 0;
-    s_egval[i] = s_eglevel[i][EG_STAGE_COUNT - 1];
+    s_pv->op[i].val = ZERO;
+    s_pv->op[i].egval = s_voicerec.eglevel[i][EG_STAGE_COUNT - 1];
+    eg_stage(i, 0);
   }
-/*
-  s_pegstage = 0;
-  s_egval = s_eglevel[EG_STAGE_COUNT - 1];
-*/
+  s_pv->pegstage = 0;
+  s_pv->pegval = s_voicerec.peglevel[EG_STAGE_COUNT - 1];
 }
 
+//only the last released note off is passed by NTS-1, so all the held notes are released
 void OSC_NOTEOFF(__attribute__((unused)) const user_osc_param_t * const params)
 {
-  for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
-    s_egstage[i] = EG_STAGE_COUNT - 1;
+  for (uint32_t k = MAX_POLY; k--;) {
+    s_pv = &s_poly[k];
+    if (!s_pv->stamp)
+      continue;
+    for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
+      eg_stage(i, EG_STAGE_COUNT - 1);
+    }
+    s_pv->pegstage = EG_STAGE_COUNT - 1;
   }
 }
 
@@ -399,6 +901,7 @@ void OSC_PARAM(uint16_t index, uint16_t value)
           break;
       }
       s_params[index] = param;
+      setopcycle();
       break;
     case k_user_osc_param_id1:
       if (s_voice != value) {
@@ -419,17 +922,13 @@ void OSC_PARAM(uint16_t index, uint16_t value)
     case k_user_osc_param_id5:
       if (s_algorithm_idx != value) {
         s_algorithm_idx = value;
-        s_algorithm = dx7_algorithm[s_algorithm_idx];
-        for (uint32_t i = DX7_OPERATOR_COUNT; i--;) {
-          if (s_algorithm[i] & ALG_FBK_MASK) {
-            s_feedback_src = 0;
-            for (uint32_t j = (s_algorithm[i] & (ALG_FBK_MASK - 1)) >> 1; j; j >>= 1, s_feedback_src++);
-          }
-        }
+        setopcycle();
       }
       break;
     case k_user_osc_param_id6:
-
+      s_max_poly = value < MAX_POLY ? value + 1 : MAX_POLY;
+      s_poly_gain = s_poly_gain_lut[s_max_poly - 1];
+      setopcycle();
       break;
     default:
       break;
@@ -39,7 +39,7 @@
 
 #define param_val_to_q31(val) ((uint32_t)(val) * 0x00200802)
 
-static const uint8_t dx7_algorithm[32][DX7_OPERATOR_COUNT] = {
+static constexpr uint8_t dx7_algorithm[32][DX7_OPERATOR_COUNT] = {
   {0x41, 0x01, 0x02, 0x84, 0x00, 0x90}, //1 = 1
   {0x00, 0x01, 0x02, 0x84, 0x50, 0x90}, //2
   {0x41, 0x01, 0x82, 0x00, 0x08, 0x90}, //3
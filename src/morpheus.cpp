@@ -11,6 +11,8 @@
 #include "fixed_math.h"
 #include "simplelfo.hpp"
 #include "userosc.h"
+#include "governor.h"
+#include "perf.h"
 
 #define FORMAT_ULAW
 #define SAMPLE_COUNT 256
@@ -26,6 +28,12 @@
 
 #define LFO_MAX_RATE (10.f / 30.f) //maximum LFO rate in Hz divided by logarithmic slope
 #define LFO_RATE_LOG_BIAS 29.8272342681884765625f //normalize logarithmic LFO for 0...1
+#define GOVERNOR_LEVELS 1 //morph interpolation is off at level 1
+
+enum {
+  perf_w0,
+  perf_render,
+};
 
 static float s_shape;
 static float s_shiftshape;
@@ -42,7 +50,7 @@ static q31_t s_phase;
 static float s_phase;
 #endif
 
-void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused)) uint32_t api)
+void OSC_INIT(uint32_t platform, __attribute__((unused)) uint32_t api)
 {
   s_shape = .0f;
   s_shiftshape = .0f;
@@ -60,6 +68,8 @@ void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused))
 #else
   s_phase = .0f;
 #endif
+  governor_init(platform, GOVERNOR_LEVELS);
+  PERF_INIT("w0", "render");
 }
 
 static inline __attribute__((optimize("Ofast"), always_inline))
@@ -109,6 +119,8 @@ float get_pos(dsp::SimpleLFO *lfo, uint32_t type, float x) {
 
 void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_t frames)
 {
+  PERF_BLOCK_BEGIN();
+  PERF_SECTION(perf_w0);
 #ifdef USE_Q31_PHASE
   q31_t w0 = f32_to_q31(osc_w0f_for_note(params->pitch >> 8, params->pitch & 0xFF));
 #else
@@ -116,7 +128,9 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
 #endif
   q31_t * __restrict y = (q31_t *)yn;
 
-  switch (s_interpolate | (s_mode << 1)) {
+  governor_start();
+  PERF_SECTION(perf_render);
+  switch ((governor_level() ? 0 : s_interpolate) | (s_mode << 1)) {
     case 0:
       for (uint32_t f = frames; f--; y++) {
 #ifdef USE_Q31
@@ -186,6 +200,8 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
       }
       break;
   }
+  governor_stop(frames);
+  PERF_BLOCK_END(frames);
 }
 
 void OSC_NOTEON(__attribute__((unused)) const user_osc_param_t * const params)
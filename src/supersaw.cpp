@@ -9,11 +9,19 @@
  */
 
 #include "userosc.h"
+#include "governor.h"
+#include "perf.h"
 
 #define MAX_UNISON 12 //maximum unison pairs
 #define MAX_DETUNE 1.f //maximum detune between neighbor unison voices in semitones
 #define MAX_POLY 12 //maximum polyphony
 #define NOPITCH 0xFFFF
+#define GOVERNOR_LEVELS 4 //unison pairs limit is halved by each level
+
+enum {
+  perf_w0,
+  perf_render,
+};
 
 static float s_unison;
 static float s_detune;
@@ -35,7 +43,7 @@ static float s_phase[MAX_POLY][MAX_UNISON * 2 + 1];
 static float s_w0[MAX_POLY][MAX_UNISON * 2 + 1];
 static uint16_t s_pitch[MAX_POLY];
 
-void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused)) uint32_t api)
+void OSC_INIT(uint32_t platform, __attribute__((unused)) uint32_t api)
 {
   s_unison = 0.f;
   s_detune = 0.f;
@@ -52,6 +60,8 @@ void OSC_INIT(__attribute__((unused)) uint32_t platform, __attribute__((unused))
   s_note_pitch = NOPITCH;
   s_old_pitch = NOPITCH;
   s_osc_pitch = NOPITCH;
+  governor_init(platform, GOVERNOR_LEVELS);
+  PERF_INIT("w0", "render");
 }
 
 __fast_inline float osc_w0f_for_notef(uint8_t note, float mod) {
@@ -66,6 +76,10 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
   uint8_t note, mod;
   bool has_frac;
 
+  PERF_BLOCK_BEGIN();
+  PERF_SECTION(perf_w0);
+  governor_start();
+
   if (s_note_pitch != s_old_pitch || params->pitch != s_osc_pitch) {
     pitch = params->pitch - s_osc_pitch + s_old_pitch;
     s_old_pitch = s_note_pitch;
@@ -84,6 +98,7 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
     frac = clipminmaxf(.0f, s_unison + lfo * s_max_unison, MAX_UNISON);
   else 
     frac = s_unison;
+  frac = clipmaxf(frac, MAX_UNISON >> governor_level());
 
   base = (uint32_t)frac;
   frac -= base;
@@ -111,6 +126,7 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
     }
   }
 
+  PERF_SECTION(perf_render);
   q31_t * __restrict y = (q31_t *)yn;
   for (uint32_t f = frames; f--; y++) {
     valf = .0f;
@@ -145,6 +161,9 @@ void OSC_CYCLE(const user_osc_param_t * const params, int32_t *yn, const uint32_
       *phase -= (uint32_t)*phase;
     }
   }
+
+  governor_stop(frames);
+  PERF_BLOCK_END(frames);
 }
 
 void OSC_NOTEON(const user_osc_param_t * const params)